@@ -0,0 +1,221 @@
+/**
+    @file
+    @author Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief Compare write and read throughput and compression ratio of chunk
+    compressions and filters on synthetic telemetry.
+*/
+
+#include <pjmsg_mcap_wrapper/all.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    using Parameters = pjmsg_mcap_wrapper::Writer::Parameters;
+
+
+    /**
+     * Typical robot telemetry: noisy sensor readings quantized to sensor
+     * resolution, random walks, counters, rarely changing mode flags and
+     * constant parameters, in equal proportions.
+     */
+    class Telemetry
+    {
+    protected:
+        std::mt19937 generator_;
+        std::normal_distribution<double> noise_;
+        std::uniform_real_distribution<double> uniform_;
+
+        std::vector<double> phases_;
+        std::vector<double> values_;
+
+    public:
+        explicit Telemetry(const std::size_t size) : generator_(42), noise_(0.0, 1.0), uniform_(0.0, 1.0)
+        {
+            phases_.resize(size);
+            values_.resize(size);
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                phases_[i] = uniform_(generator_) * 2.0 * M_PI;
+                values_[i] = std::round(uniform_(generator_) * 1000.0);
+            }
+        }
+
+        void fill(pjmsg_mcap_wrapper::Message &message, const std::size_t index)
+        {
+            const double time = static_cast<double>(index) * 1e-3;
+
+            for (std::size_t i = 0; i < values_.size(); ++i)
+            {
+                switch (i % 5)
+                {
+                    case 0:
+                        values_[i] = std::sin(time + phases_[i]) + 0.01 * noise_(generator_);
+                        values_[i] = std::round(values_[i] * 1e4) * 1e-4;
+                        break;
+                    case 1:
+                        values_[i] += 1e-3 * noise_(generator_);
+                        break;
+                    case 2:
+                        values_[i] += 1.0;
+                        break;
+                    case 3:
+                        if (uniform_(generator_) < 1e-3)
+                        {
+                            values_[i] = std::floor(uniform_(generator_) * 4.0);
+                        }
+                        break;
+                    default:
+                        break;
+                }
+                message.value(i) = values_[i];
+            }
+        }
+    };
+
+
+    struct Configuration
+    {
+        std::string name_;
+        Parameters::Compression compression_;
+        Parameters::CompressionLevel level_;
+        Parameters::ChunkFilter filter_ = Parameters::ChunkFilter::NONE;
+    };
+
+
+    double getSeconds(const std::chrono::steady_clock::time_point start)
+    {
+        return (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+}  // namespace
+
+
+int main(int argc, char **argv)
+{
+    if (argc < 2 or argc > 4)
+    {
+        std::cerr << "Usage: " << argv[0] << " <output_directory> [messages=20000] [signals=300]" << std::endl;
+        return (EXIT_FAILURE);
+    }
+
+    try
+    {
+        const std::filesystem::path directory = argv[1];                          // NOLINT
+        const std::size_t message_count = argc > 2 ? std::stoul(argv[2]) : 20000;  // NOLINT
+        const std::size_t signal_count = argc > 3 ? std::stoul(argv[3]) : 300;     // NOLINT
+
+        const std::vector<Configuration> configurations = {
+            { "none", Parameters::Compression::NONE, Parameters::CompressionLevel::DEFAULT },
+            { "lz4_fastest", Parameters::Compression::LZ4, Parameters::CompressionLevel::FASTEST },
+            { "lz4", Parameters::Compression::LZ4, Parameters::CompressionLevel::DEFAULT },
+            { "lz4_slow", Parameters::Compression::LZ4, Parameters::CompressionLevel::SLOW },
+            { "zstd_fastest", Parameters::Compression::ZSTD, Parameters::CompressionLevel::FASTEST },
+            { "zstd", Parameters::Compression::ZSTD, Parameters::CompressionLevel::DEFAULT },
+            { "zstd_slow", Parameters::Compression::ZSTD, Parameters::CompressionLevel::SLOW },
+            // ChunkFilter::SHUFFLE overhead
+            { "shuffle+lz4",
+              Parameters::Compression::LZ4,
+              Parameters::CompressionLevel::DEFAULT,
+              Parameters::ChunkFilter::SHUFFLE },
+            { "shuffle+zstd_f",
+              Parameters::Compression::ZSTD,
+              Parameters::CompressionLevel::FASTEST,
+              Parameters::ChunkFilter::SHUFFLE },
+            { "shuffle+zstd",
+              Parameters::Compression::ZSTD,
+              Parameters::CompressionLevel::DEFAULT,
+              Parameters::ChunkFilter::SHUFFLE },
+        };
+
+        const double raw_megabytes =
+                static_cast<double>(message_count * signal_count * sizeof(double)) / (1024.0 * 1024.0);
+        double uncompressed_size = 0.0;
+
+        std::cout << std::left << std::setw(16) << "configuration" << std::right << std::setw(12) << "size, MB"
+                  << std::setw(8) << "ratio" << std::setw(14) << "write, MB/s" << std::setw(14) << "read, MB/s"
+                  << std::endl;
+
+        for (const Configuration &configuration : configurations)
+        {
+            const std::filesystem::path filename = directory / (configuration.name_ + ".mcap");
+
+            pjmsg_mcap_wrapper::Message message;
+            message.resize(signal_count);
+            for (std::size_t i = 0; i < signal_count; ++i)
+            {
+                message.name(i) = "signal_" + std::to_string(i);
+            }
+            Telemetry telemetry(signal_count);
+
+            Parameters params;
+            params.compression_ = configuration.compression_;
+            params.compression_level_ = configuration.level_;
+            params.chunk_filter_ = configuration.filter_;
+
+            // data generation is excluded from timing
+            double write_time = 0.0;
+            std::chrono::steady_clock::time_point close_start;
+            {
+                pjmsg_mcap_wrapper::Writer writer;
+                writer.initialize(filename, "/bench", params);
+
+                for (std::size_t i = 0; i < message_count; ++i)
+                {
+                    telemetry.fill(message, i);
+
+                    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                    writer.write(message);
+                    write_time += getSeconds(start);
+                }
+
+                // the last chunk is written on destruction
+                close_start = std::chrono::steady_clock::now();
+            }
+            write_time += getSeconds(close_start);
+
+            pjmsg_mcap_wrapper::Reader::Parameters reader_params;
+            reader_params.threads_ = 1;
+
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            pjmsg_mcap_wrapper::Reader reader;
+            reader.open(filename, reader_params);
+            const pjmsg_mcap_wrapper::Reader::Series series = reader.read("/bench");
+            const double read_time = getSeconds(start);
+
+            if (series.timestamps_.size() != message_count)
+            {
+                std::cerr << configuration.name_ << ": unexpected number of messages" << std::endl;
+                return (EXIT_FAILURE);
+            }
+
+            const double size = static_cast<double>(std::filesystem::file_size(filename));
+            if (Parameters::Compression::NONE == configuration.compression_)
+            {
+                uncompressed_size = size;
+            }
+
+            std::cout << std::left << std::setw(16) << configuration.name_ << std::right << std::fixed
+                      << std::setprecision(2) << std::setw(12) << size / (1024.0 * 1024.0) << std::setw(8)
+                      << uncompressed_size / size << std::setprecision(1) << std::setw(14)
+                      << raw_megabytes / write_time << std::setw(14) << raw_megabytes / read_time << std::endl;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return (EXIT_FAILURE);
+    }
+
+    return (EXIT_SUCCESS);
+}
@@ -8,3 +8,9 @@
 #pragma once
 
 #include "writer.h"
+#include "reader.h"
+#include "replayer.h"
+#include "xor_decoder.h"
+#include "sparse_decoder.h"
+#include "chunk_decoder.h"
+#include "zstd_dictionary.h"
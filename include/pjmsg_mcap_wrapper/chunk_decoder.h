@@ -0,0 +1,45 @@
+/**
+    @file
+    @author  Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+*/
+
+#pragma once
+
+#include "common.h"
+
+namespace pjmsg_mcap_wrapper
+{
+    /**
+     * Decompresses MCAP chunk data, supports standard '', 'zstd', and 'lz4'
+     * compression, and 'shuffle+' chunks written with
+     * Writer::Parameters::ChunkFilter::SHUFFLE.
+     */
+    class PJMSG_MCAP_WRAPPER_PUBLIC ChunkDecoder
+    {
+    public:
+        class Implementation;
+
+    protected:
+        const std::unique_ptr<Implementation> pimpl_;
+
+    public:
+        ChunkDecoder();
+        ~ChunkDecoder();
+
+        /// Dictionary of ZSTD compressed chunks, see
+        /// ZstdDictionary::read(); empty -- no dictionary.
+        void setZstdDictionary(const std::vector<std::byte> &dictionary);
+
+        /**
+         * Returns chunk records, the buffer is reused by subsequent calls.
+         * Throws if compression is not supported or the data is corrupted.
+         */
+        const std::vector<std::byte> &decode(
+                const std::string &compression,
+                const std::byte *data,
+                const std::size_t size,
+                const uint64_t uncompressed_size);
+    };
+}  // namespace pjmsg_mcap_wrapper
@@ -0,0 +1,96 @@
+/**
+    @file
+    @author  Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+*/
+
+#pragma once
+
+#include "common.h"
+
+#include <map>
+#include <string>
+
+namespace pjmsg_mcap_wrapper
+{
+    /**
+     * Reads recordings produced by Writer: values of each stream, i.e.,
+     * topic prefix, are matched with names of the corresponding version
+     * and returned as columns. All values encodings and chunk compressions
+     * supported by Writer are handled, the ZSTD dictionary is loaded from
+     * the recording.
+     */
+    class PJMSG_MCAP_WRAPPER_PUBLIC Reader
+    {
+    public:
+        struct PJMSG_MCAP_WRAPPER_PUBLIC Parameters
+        {
+            /**
+             * Decompress and decode chunks in this many threads, 0 -- number
+             * of hardware threads. Chunks are located using the chunk index
+             * of the summary section and merged in order of their start
+             * times. Recordings without chunk index, e.g., uncompressed, are
+             * decoded in the calling thread.
+             */
+            std::size_t threads_ = 0;
+
+            Parameters(){};
+        };
+
+        /// Time series of a stream.
+        struct PJMSG_MCAP_WRAPPER_PUBLIC Series
+        {
+            /// Message stamps (nanoseconds) in file order.
+            std::vector<uint64_t> timestamps_;
+            /// Signal names in order of their first appearance.
+            std::vector<std::string> names_;
+            /// values_[i][j] -- value of names_[i] at timestamps_[j], NaN if
+            /// the signal is missing in the message.
+            std::vector<std::vector<double>> values_;
+        };
+
+    protected:
+        class Implementation;
+
+    protected:
+        const std::unique_ptr<Implementation> pimpl_;
+
+    public:
+        Reader();
+        ~Reader();
+
+        void open(const std::filesystem::path &filename, const Parameters &params = Parameters{});
+
+        /// Read all streams, keys are topic prefixes.
+        [[nodiscard]] std::map<std::string, Series> read();
+        /// Read a single stream, throws if it is not found.
+        [[nodiscard]] Series read(const std::string &topic_prefix);
+        /**
+         * Read the given signals of a single stream, columns follow the
+         * order of signals, throws if a signal is not found. Only the
+         * requested values are copied from messages: their positions are
+         * computed once per names version. Cheap for a few signals of wide
+         * messages, except for XOR and sparse encodings, which still require
+         * decoding of whole messages.
+         */
+        [[nodiscard]] Series read(const std::string &topic_prefix, const std::vector<std::string> &signals);
+        /**
+         * Read values of a single stream logged in [start_time, end_time)
+         * (nanoseconds), see Writer::Parameters::clock_; empty signals --
+         * all, signals that are not found in the range are NaN. Only chunks
+         * overlapping the range and the last preceding chunk with names of
+         * the stream are decoded, they are located using the chunk index and
+         * message indexes of the summary. If message indexes are disabled,
+         * see Writer::Parameters::message_index_, chunks with names cannot be
+         * located and all preceding chunks are decoded. Recordings without
+         * chunk index, e.g., uncompressed, are indexed by the first call: a
+         * sparse time index of file blocks is kept until the next open().
+         */
+        [[nodiscard]] Series range(
+                const std::string &topic_prefix,
+                const uint64_t start_time,
+                const uint64_t end_time,
+                const std::vector<std::string> &signals = std::vector<std::string>());
+    };
+}  // namespace pjmsg_mcap_wrapper
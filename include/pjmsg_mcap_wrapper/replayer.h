@@ -0,0 +1,63 @@
+/**
+    @file
+    @author  Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+*/
+
+#pragma once
+
+#include "common.h"
+
+#include <string>
+
+namespace pjmsg_mcap_wrapper
+{
+    /**
+     * Sequential reader of recordings produced by Writer for replay: the
+     * file is memory mapped and records are parsed in place, values
+     * messages are returned one by one in file order without per-message
+     * allocations. Intended for uncompressed recordings
+     * (Writer::Parameters::Compression::NONE), where plain values are not
+     * copied at all; compressed chunks are supported, but decompressed into
+     * an internal buffer.
+     */
+    class PJMSG_MCAP_WRAPPER_PUBLIC Replayer
+    {
+    public:
+        /// Values message, valid until the next call of next().
+        struct PJMSG_MCAP_WRAPPER_PUBLIC Sample
+        {
+            const std::string *topic_prefix_ = nullptr;
+            /// Message stamp (nanoseconds).
+            uint64_t timestamp_ = 0;
+            uint32_t names_version_ = 0;
+            /// Names of the corresponding version, nullptr if they have not
+            /// been encountered yet.
+            const std::vector<std::string> *names_ = nullptr;
+            /**
+             * Points directly into the mapped file if values are plain
+             * doubles properly aligned in the file, otherwise to an internal
+             * buffer, e.g., for FLOAT32, XOR, sparse encodings.
+             */
+            const double *values_ = nullptr;
+            std::size_t size_ = 0;
+        };
+
+    protected:
+        class Implementation;
+
+    protected:
+        const std::unique_ptr<Implementation> pimpl_;
+
+    public:
+        Replayer();
+        ~Replayer();
+
+        void open(const std::filesystem::path &filename);
+        /// Start over from the beginning of the recording.
+        void rewind();
+        /// Returns false at the end of the recording.
+        [[nodiscard]] bool next(Sample &sample);
+    };
+}  // namespace pjmsg_mcap_wrapper
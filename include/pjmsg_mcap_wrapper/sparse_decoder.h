@@ -0,0 +1,41 @@
+/**
+    @file
+    @author  Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+*/
+
+#pragma once
+
+#include "message.h"
+
+namespace pjmsg_mcap_wrapper
+{
+    /**
+     * Decoder of 'pjmsg_sparse' channels written with
+     * Writer::Parameters::ValuesEncoding::SPARSE, reconstructs dense values
+     * from changed ones. Each message depends on the previous message of the
+     * same channel, so messages of a channel must be decoded in file order
+     * starting from a keyframe; each chunk starts with a keyframe. Use a
+     * separate decoder for each channel.
+     */
+    class PJMSG_MCAP_WRAPPER_PUBLIC SparseDecoder
+    {
+    public:
+        class Implementation;
+
+    protected:
+        const std::unique_ptr<Implementation> pimpl_;
+
+    public:
+        SparseDecoder();
+        ~SparseDecoder();
+
+        /// Forget previous message, e.g., when skipping to another chunk.
+        void reset();
+        /// Set stamp, names version, and values of the message, names are
+        /// not modified.
+        void decode(const std::byte *data, const std::size_t size, Message &message);
+        [[nodiscard]] static bool isKeyframe(const std::byte *data, const std::size_t size);
+    };
+}  // namespace pjmsg_mcap_wrapper
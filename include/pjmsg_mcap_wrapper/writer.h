@@ -16,15 +16,235 @@ namespace pjmsg_mcap_wrapper
     public:
         struct PJMSG_MCAP_WRAPPER_PUBLIC Parameters
         {
+            /**
+             * Chunk compression:
+             * - NONE -- chunking is disabled;
+             * - ZSTD -- good ratio, moderate CPU load;
+             * - LZ4 -- LZ4 frame compression, lower ratio but faster
+             *   compression and decompression, suitable for slow CPUs.
+             */
             enum class PJMSG_MCAP_WRAPPER_PUBLIC Compression
             {
                 NONE,
-                ZSTD
+                ZSTD,
+                LZ4
             } compression_ = Compression::NONE;
+            /// Compression level, mapped to library specific levels as in
+            /// MCAP, except that DEFAULT selects the fast mode of LZ4.
+            enum class PJMSG_MCAP_WRAPPER_PUBLIC CompressionLevel
+            {
+                FASTEST,
+                FAST,
+                DEFAULT,
+                SLOW,
+                SLOWEST
+            } compression_level_ = CompressionLevel::DEFAULT;
+            /**
+             * ZSTD only: compression_level_ is the initial level, which is
+             * lowered when compression of a chunk takes more than 80% of
+             * the time it took to fill the chunk (accounting for
+             * compression_threads_), and raised when it takes less than 20%.
+             */
+            bool adaptive_compression_ = false;
+            /**
+             * ZSTD only: compress records incrementally as they are
+             * written, so that each write performs a bounded amount of
+             * compression work and closing a chunk only finalizes the
+             * frame. Ignored if compression_threads_ > 0, not compatible
+             * with ChunkFilter::SHUFFLE.
+             */
+            bool streaming_compression_ = false;
+            /// Chunk is closed when its size exceeds this many bytes.
+            std::size_t chunk_size_ = 768 * 1024;
+            /// CRC of chunk records.
+            bool chunk_crc_ = true;
+            /// CRC of the data section.
+            bool data_crc_ = false;
+            /// CRC of the summary section.
+            bool summary_crc_ = true;
+            /// Per-chunk message indices, required for reading messages in
+            /// time order.
+            bool message_index_ = true;
+            /// Summary section: statistics, chunk and metadata indices,
+            /// repeated schemas and channels.
+            bool summary_ = true;
+            /// ZSTD compression with a dictionary trained on similar data,
+            /// see ZstdDictionary, improves ratio of small chunks. The
+            /// dictionary is stored in each file as an attachment.
+            std::vector<std::byte> zstd_dictionary_;
+            /**
+             * Transform applied to chunk records before compression:
+             * - NONE -- standard MCAP chunks;
+             * - SHUFFLE -- messages of the same channel and size are
+             *   transposed byte-wise, which groups slowly changing bytes of
+             *   values together and improves compression ratio. Such chunks
+             *   are marked with 'shuffle+zstd' or 'shuffle+lz4' compression
+             *   and can only be decoded with ChunkDecoder.
+             */
+            enum class PJMSG_MCAP_WRAPPER_PUBLIC ChunkFilter
+            {
+                NONE,
+                SHUFFLE
+            } chunk_filter_ = ChunkFilter::NONE;
+            /**
+             * Encoding of values:
+             * - CDR -- plotjuggler_msgs/msg/StatisticsValues on
+             *   '<topic_prefix>/values';
+             * - XOR -- compact delta encoding on '<topic_prefix>/values_xor',
+             *   see XorDecoder, not supported by PlotJuggler;
+             * - SPARSE -- only changed values on
+             *   '<topic_prefix>/values_sparse', see SparseDecoder, suitable
+             *   for wide messages with mostly static values, not supported
+             *   by PlotJuggler;
+             * - FLOAT32 -- plotjuggler_msgs/msg/StatisticsValuesFloat32 on
+             *   '<topic_prefix>/values', values are converted to float, which
+             *   halves their size.
+             */
+            enum class PJMSG_MCAP_WRAPPER_PUBLIC ValuesEncoding
+            {
+                CDR,
+                XOR,
+                SPARSE,
+                FLOAT32
+            } values_encoding_ = ValuesEncoding::CDR;
+            /// XOR encoding: write a keyframe at least every this many
+            /// messages, chunks always start with a keyframe.
+            std::size_t xor_keyframe_interval_ = 100;
+            /// SPARSE encoding: same as xor_keyframe_interval_.
+            std::size_t sparse_keyframe_interval_ = 100;
+
+            /**
+             * Source of message log time:
+             * - SYSTEM -- system (wall) clock;
+             * - MONOTONIC -- CLOCK_MONOTONIC;
+             * - MONOTONIC_COARSE -- CLOCK_MONOTONIC_COARSE, cheaper but has
+             *   resolution of a few milliseconds;
+             * - TSC -- time stamp counter calibrated against CLOCK_MONOTONIC
+             *   on initialization (takes 200ms), requires invariant TSC,
+             *   x86 only; the measured period is stored in file metadata;
+             * - MESSAGE_STAMP -- stamp set with Message::setStamp().
+             * Correspondence of the clock to wall time is stored in file
+             * metadata.
+             */
+            enum class PJMSG_MCAP_WRAPPER_PUBLIC Clock
+            {
+                SYSTEM,
+                MONOTONIC,
+                MONOTONIC_COARSE,
+                TSC,
+                MESSAGE_STAMP
+            } clock_ = Clock::SYSTEM;
+            /// Compress chunks in this many threads, chunks are still written
+            /// in order. 0 -- compress in the writing thread.
+            std::size_t compression_threads_ = 0;
+            /**
+             * Write compressed chunk to the file when its oldest message is
+             * older than this, 0 -- chunks are written only when full. In
+             * synchronous mode the check is performed on writes only, i.e.,
+             * the bound is not enforced while no messages are written, use
+             * flush() to write the pending chunk in this case. Latency is
+             * measured with CLOCK_MONOTONIC, in synchronous mode with SYSTEM
+             * or MESSAGE_STAMP clocks -- with CLOCK_MONOTONIC_COARSE.
+             */
+            std::chrono::microseconds max_chunk_latency_ = std::chrono::microseconds(0);
+
+            /**
+             * Flight recorder mode: nothing is written until trigger(), the
+             * most recent chunks with total size up to recorder_size_ bytes
+             * and time span up to recorder_duration_ are kept in memory.
+             * The mode is enabled if any of these limits is nonzero.
+             */
+            std::size_t recorder_size_ = 0;
+            std::chrono::microseconds recorder_duration_ = std::chrono::microseconds(0);
+            /// Messages are written for this duration after trigger(), then
+            /// the file is closed and subsequent messages are ignored.
+            std::chrono::microseconds recorder_post_duration_ = std::chrono::microseconds(0);
+
+            /**
+             * Start a new file when the current one exceeds rotation_size_
+             * bytes or rotation_duration_ since its first message, 0 --
+             * disabled. Files are named '<stem>_<index><extension>', the next
+             * file is opened in advance and the previous one is finalized in
+             * a separate thread. Names are repeated in each file.
+             */
+            std::size_t rotation_size_ = 0;
+            std::chrono::microseconds rotation_duration_ = std::chrono::microseconds(0);
+
+            /// Serialize and write messages in a background thread, write()
+            /// only copies messages to a preallocated queue.
+            bool async_ = false;
+            /// Number of messages that can be queued in async mode.
+            std::size_t async_queue_size_ = 64;
+            /// Background thread wakeup period when the queue is empty.
+            std::chrono::microseconds async_period_ = std::chrono::microseconds(1000);
+            /**
+             * Handling of async writes when the queue is full, e.g., because
+             * the disk or compression can not keep up:
+             * - BLOCK -- wait for a free slot, the caller sleeps until the
+             *   background thread releases one;
+             * - DROP_NEWEST -- drop the message;
+             * - DROP_OLDEST -- drop the oldest queued message; messages
+             *   with name updates are never dropped, so the caller blocks as
+             *   in BLOCK mode when the oldest queued message carries names;
+             * - DECIMATE -- keep only every decimation_-th message while the
+             *   queue is at least half full, drop the message if it is full.
+             * Dropped messages are counted, see getQueueStatistics(), and
+             * each gap is marked with a JSON message on
+             * '<topic_prefix>/dropped'. Name updates are not lost: they are
+             * passed on to the next queued message.
+             */
+            enum class PJMSG_MCAP_WRAPPER_PUBLIC Backpressure
+            {
+                BLOCK,
+                DROP_NEWEST,
+                DROP_OLDEST,
+                DECIMATE
+            } backpressure_ = Backpressure::BLOCK;
+            std::size_t decimation_ = 2;
+            /**
+             * Messages from different streams are ordered by time in async
+             * mode, a message is delayed by at most this duration while
+             * waiting for older messages from idle streams. With
+             * Clock::MESSAGE_STAMP the window is measured in message stamps:
+             * a message is delayed until a message stamped at least this much
+             * later is queued in any stream, or until the writer is closed.
+             */
+            std::chrono::microseconds merge_window_ = std::chrono::microseconds(10000);
 
             Parameters(){};
         };
 
+        /// Options of a message stream added with addStream().
+        struct PJMSG_MCAP_WRAPPER_PUBLIC StreamParameters
+        {
+            /**
+             * Minimum interval between written messages of the stream, e.g.,
+             * slow signals can be written at their own rate from a fast
+             * loop. Messages that come earlier are skipped without gap
+             * markers, their name updates are written with the next message.
+             * The interval is measured in log time, or in sample timestamps
+             * in writeBatch().
+             */
+            std::chrono::nanoseconds period_ = std::chrono::nanoseconds(0);
+
+            StreamParameters(){};
+        };
+
+        /// Counters of async writes summed over all streams.
+        struct PJMSG_MCAP_WRAPPER_PUBLIC QueueStatistics
+        {
+            /// Messages queued, including those dropped later in
+            /// Backpressure::DROP_OLDEST mode.
+            uint64_t queued_ = 0;
+            /// Messages dropped according to Parameters::backpressure_,
+            /// tryWrite() drops the newest message when the queue is full.
+            uint64_t overflows_ = 0;
+            /// Messages dropped because they did not fit into queue slots
+            /// preallocated with reserve(), or because the writer is not in
+            /// async mode or its background thread failed.
+            uint64_t rejected_ = 0;
+        };
+
     protected:
         class Implementation;
 
@@ -34,11 +254,79 @@ namespace pjmsg_mcap_wrapper
     public:
         Writer();
         ~Writer();
+        /**
+         * Messages are written to '<topic_prefix>/names' and
+         * '<topic_prefix>/values' topics unless they are added with
+         * addStream().
+         */
         void initialize(
                 const std::filesystem::path &filename,
                 const std::string &topic_prefix,
                 const Parameters &params = Parameters{});
+        /**
+         * Write the message to topics with a different prefix, must be called
+         * before initialize(). Any number of streams can be added, they share
+         * the file, chunks and compression, but have separate names versions
+         * and can be written at different rates. In async mode each added
+         * message can be written from its own thread: messages are staged in
+         * separate queues and merged by the background thread.
+         */
+        void addStream(
+                const Message &message,
+                const std::string &topic_prefix,
+                const StreamParameters &params = StreamParameters{});
+        /**
+         * Close current chunk and write it to the file even if it is not
+         * full. In async mode flush is only requested, it is performed later
+         * by the background thread.
+         */
         void flush();
+        /**
+         * Write queued messages and finalize files, errors of background
+         * operations (async writing, compression, file rotation) are
+         * rethrown here. Performed by destructor if not called explicitly,
+         * but errors are ignored in this case. The writer must not be used
+         * afterwards.
+         */
+        void close();
+        /**
+         * Flight recorder mode only: write recorded messages and the last
+         * names of each stream, continue writing for
+         * Parameters::recorder_post_duration_. In async mode the trigger is
+         * handled by the background thread after queued messages.
+         */
+        void trigger();
+        /// In async mode must always be called from the same thread for a
+        /// given stream.
         void write(const Message &message);
+        /**
+         * Async mode only: preallocate queue slots of the message stream for
+         * the current number of values, names and frame_id of the message,
+         * which is required by tryWrite(). Waits until the queue is empty,
+         * must be called from the thread that writes the message.
+         */
+        void reserve(const Message &message);
+        /**
+         * Real-time safe variant of write() for async mode: does not
+         * allocate memory, lock, block or throw. The message is copied to a
+         * slot preallocated with reserve(), false is returned if the message
+         * is dropped, see getQueueStatistics(), or skipped according to
+         * StreamParameters::period_. Clock::TSC and
+         * Clock::MESSAGE_STAMP timestamps do not involve system calls, other
+         * clocks rely on vDSO implementation of clock_gettime().
+         */
+        bool tryWrite(const Message &message) noexcept;
+        [[nodiscard]] QueueStatistics getQueueStatistics() const;
+        /**
+         * Write a row-major block of samples x message.size() values, i-th
+         * row is stamped with timestamps[i] (nanoseconds), names and version
+         * are taken from the message. Cheaper than calling write() for each
+         * row.
+         */
+        void writeBatch(
+                const Message &message,
+                const double *values,
+                const uint64_t *timestamps,
+                const std::size_t samples);
     };
 }  // namespace pjmsg_mcap_wrapper
@@ -0,0 +1,35 @@
+/**
+    @file
+    @author  Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+*/
+
+#pragma once
+
+#include "common.h"
+
+namespace pjmsg_mcap_wrapper
+{
+    /**
+     * ZSTD dictionaries for Writer::Parameters::zstd_dictionary_: a
+     * dictionary trained on a sample recording allows small chunks to be
+     * compressed almost as well as large ones.
+     */
+    class PJMSG_MCAP_WRAPPER_PUBLIC ZstdDictionary
+    {
+    public:
+        /// Train dictionary of at most size bytes on message records of the
+        /// given recordings.
+        static std::vector<std::byte> train(
+                const std::vector<std::filesystem::path> &recordings,
+                const std::size_t size);
+
+        /// Returns dictionary stored in the recording, empty if there is
+        /// none, see ChunkDecoder::setZstdDictionary().
+        static std::vector<std::byte> read(const std::filesystem::path &recording);
+
+        static std::vector<std::byte> load(const std::filesystem::path &filename);
+        static void save(const std::filesystem::path &filename, const std::vector<std::byte> &dictionary);
+    };
+}  // namespace pjmsg_mcap_wrapper
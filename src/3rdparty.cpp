@@ -19,5 +19,6 @@
 #include "HeaderCdrAux.ipp"
 #include "StatisticsNamesCdrAux.ipp"
 #include "StatisticsValuesCdrAux.ipp"
+#include "StatisticsValuesFloat32CdrAux.ipp"
 #include "TimeCdrAux.ipp"
 
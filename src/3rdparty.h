@@ -11,10 +11,10 @@
 #include "HeaderCdrAux.hpp"
 #include "StatisticsNamesCdrAux.hpp"
 #include "StatisticsValuesCdrAux.hpp"
+#include "StatisticsValuesFloat32CdrAux.hpp"
 #include "TimeCdrAux.hpp"
 
 #include <fastcdr/Cdr.h>
 #include <fastcdr/CdrSizeCalculator.hpp>
 
-#define MCAP_COMPRESSION_NO_LZ4
 #define MCAP_PUBLIC __attribute__((visibility("hidden")))
@@ -0,0 +1,57 @@
+/**
+    @file
+    @author Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#pragma once
+
+#include <string>
+
+namespace pjmsg_mcap_wrapper
+{
+    /// Channels written by Writer.
+    enum class ChannelType
+    {
+        NAMES,
+        VALUES,
+        VALUES_FLOAT32,
+        VALUES_XOR,
+        VALUES_SPARSE
+    };
+
+
+    /// Returns false if the schema is not written by Writer.
+    inline bool getChannelType(const std::string &schema, ChannelType &type)
+    {
+        using pjmsg_mcap_wrapper_private::pjmsg::Message;
+
+        if (Message<plotjuggler_msgs::msg::StatisticsNames>::type == schema)
+        {
+            type = ChannelType::NAMES;
+        }
+        else if (Message<plotjuggler_msgs::msg::StatisticsValues>::type == schema)
+        {
+            type = ChannelType::VALUES;
+        }
+        else if (Message<plotjuggler_msgs::msg::StatisticsValuesFloat32>::type == schema)
+        {
+            type = ChannelType::VALUES_FLOAT32;
+        }
+        else if (xor_codec::SCHEMA_NAME == schema)
+        {
+            type = ChannelType::VALUES_XOR;
+        }
+        else if (sparse_codec::SCHEMA_NAME == schema)
+        {
+            type = ChannelType::VALUES_SPARSE;
+        }
+        else
+        {
+            return (false);
+        }
+        return (true);
+    }
+}  // namespace pjmsg_mcap_wrapper
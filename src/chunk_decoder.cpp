@@ -0,0 +1,201 @@
+/**
+    @file
+    @author Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#include "pjmsg_mcap_wrapper/chunk_decoder.h"
+#include "util.h"
+#include "chunk_filter.h"
+
+#include <stdexcept>
+#include <string>
+
+#include <lz4frame.h>
+#include <zstd.h>
+
+
+namespace pjmsg_mcap_wrapper
+{
+    class ChunkDecoder::Implementation
+    {
+    public:
+        ZSTD_DCtx *zstd_context_ = nullptr;
+        LZ4F_dctx *lz4_context_ = nullptr;
+        ChunkShuffler shuffler_;
+        std::vector<std::byte> records_;
+        std::vector<std::byte> shuffled_;
+
+    public:
+        ~Implementation()
+        {
+            ZSTD_freeDCtx(zstd_context_);
+            LZ4F_freeDecompressionContext(lz4_context_);
+        }
+
+        void initializeZstd()
+        {
+            if (nullptr == zstd_context_)
+            {
+                zstd_context_ = ZSTD_createDCtx();
+                SHARF_THROW_IF(nullptr == zstd_context_, "Failed to create ZSTD context");
+            }
+        }
+
+        void setZstdDictionary(const std::vector<std::byte> &dictionary)
+        {
+            initializeZstd();
+
+            // empty dictionary resets the context
+            const std::size_t result = ZSTD_DCtx_loadDictionary(zstd_context_, dictionary.data(), dictionary.size());
+            SHARF_THROW_IF(ZSTD_isError(result), "Failed to load ZSTD dictionary: ", ZSTD_getErrorName(result));
+        }
+
+        void decompressZstd(
+                const std::byte *data,
+                const std::size_t size,
+                const uint64_t expected_size,
+                std::vector<std::byte> &output)
+        {
+            initializeZstd();
+
+            unsigned long long content_size = ZSTD_getFrameContentSize(data, size);
+            if (ZSTD_CONTENTSIZE_UNKNOWN == content_size and 0 != expected_size)
+            {
+                content_size = expected_size;
+            }
+            SHARF_THROW_IF(
+                    ZSTD_CONTENTSIZE_ERROR == content_size or ZSTD_CONTENTSIZE_UNKNOWN == content_size,
+                    "Unknown size of ZSTD compressed chunk");
+
+            output.resize(content_size);
+            const std::size_t result = ZSTD_decompressDCtx(zstd_context_, output.data(), output.size(), data, size);
+            SHARF_THROW_IF(ZSTD_isError(result), "ZSTD decompression failed: ", ZSTD_getErrorName(result));
+            SHARF_THROW_IF(result != output.size(), "ZSTD decompressed size mismatch");
+        }
+
+        void decompressLz4(
+                const std::byte *data,
+                const std::size_t size,
+                const uint64_t expected_size,
+                std::vector<std::byte> &output)
+        {
+            if (nullptr == lz4_context_)
+            {
+                const LZ4F_errorCode_t error = LZ4F_createDecompressionContext(&lz4_context_, LZ4F_VERSION);
+                SHARF_THROW_IF(LZ4F_isError(error), "Failed to create LZ4 context: ", LZ4F_getErrorName(error));
+            }
+            else
+            {
+                LZ4F_resetDecompressionContext(lz4_context_);
+            }
+
+            LZ4F_frameInfo_t frame_info;
+            std::size_t consumed = size;
+            std::size_t result = LZ4F_getFrameInfo(lz4_context_, &frame_info, data, &consumed);
+            SHARF_THROW_IF(LZ4F_isError(result), "LZ4 decompression failed: ", LZ4F_getErrorName(result));
+            if (0 == frame_info.contentSize)
+            {
+                SHARF_THROW_IF(0 == expected_size, "Unknown size of LZ4 compressed chunk");
+                frame_info.contentSize = expected_size;
+            }
+
+            output.resize(frame_info.contentSize);
+            std::size_t produced = 0;
+            while (0 != result)
+            {
+                std::size_t source_size = size - consumed;
+                std::size_t destination_size = output.size() - produced;
+                result = LZ4F_decompress(
+                        lz4_context_,
+                        output.data() + produced,  // NOLINT
+                        &destination_size,
+                        data + consumed,  // NOLINT
+                        &source_size,
+                        nullptr);
+                SHARF_THROW_IF(LZ4F_isError(result), "LZ4 decompression failed: ", LZ4F_getErrorName(result));
+                SHARF_THROW_IF(
+                        0 != result and 0 == source_size and 0 == destination_size, "LZ4 compressed chunk is truncated");
+
+                consumed += source_size;
+                produced += destination_size;
+            }
+            SHARF_THROW_IF(produced != output.size(), "LZ4 decompressed size mismatch");
+        }
+
+        /// expected_size is used if the frame does not specify content
+        /// size, 0 -- unknown.
+        void decompress(
+                const std::string &compression,
+                const std::byte *data,
+                const std::size_t size,
+                const uint64_t expected_size,
+                std::vector<std::byte> &output)
+        {
+            if (compression.empty())
+            {
+                output.assign(data, data + size);  // NOLINT
+            }
+            else if ("zstd" == compression)
+            {
+                decompressZstd(data, size, expected_size, output);
+            }
+            else if ("lz4" == compression)
+            {
+                decompressLz4(data, size, expected_size, output);
+            }
+            else
+            {
+                SHARF_THROW_IF(true, "Unsupported chunk compression: ", compression);
+            }
+        }
+
+        const std::vector<std::byte> &decode(
+                const std::string &compression,
+                const std::byte *data,
+                const std::size_t size,
+                const uint64_t uncompressed_size)
+        {
+            const std::string prefix = ChunkShuffler::COMPRESSION_PREFIX;
+
+            if (0 == compression.compare(0, prefix.size(), prefix))
+            {
+                decompress(compression.substr(prefix.size()), data, size, 0, shuffled_);
+                shuffler_.unshuffle(shuffled_.data(), shuffled_.size(), records_);
+            }
+            else
+            {
+                decompress(compression, data, size, uncompressed_size, records_);
+            }
+
+            SHARF_THROW_IF(records_.size() != uncompressed_size, "Decoded chunk size mismatch");
+            return (records_);
+        }
+    };
+}  // namespace pjmsg_mcap_wrapper
+
+
+namespace pjmsg_mcap_wrapper
+{
+    ChunkDecoder::ChunkDecoder() : pimpl_(std::make_unique<ChunkDecoder::Implementation>())
+    {
+    }
+
+    ChunkDecoder::~ChunkDecoder() = default;
+
+    void ChunkDecoder::setZstdDictionary(const std::vector<std::byte> &dictionary)
+    {
+        pimpl_->setZstdDictionary(dictionary);
+    }
+
+    const std::vector<std::byte> &ChunkDecoder::decode(
+            const std::string &compression,
+            const std::byte *data,
+            const std::size_t size,
+            const uint64_t uncompressed_size)
+    {
+        return (pimpl_->decode(compression, data, size, uncompressed_size));
+    }
+}  // namespace pjmsg_mcap_wrapper
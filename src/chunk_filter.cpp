@@ -0,0 +1,253 @@
+/**
+    @file
+    @author Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "util.h"
+#include "chunk_filter.h"
+
+
+namespace pjmsg_mcap_wrapper
+{
+    namespace
+    {
+        /// opcode + length
+        constexpr std::size_t RECORD_HEADER_SIZE = 1 + 8;
+        /// mcap::OpCode::Message
+        constexpr uint8_t MESSAGE_OPCODE = 0x05;
+        /// Rows of a group are transposed in tiles of this size to stay in cache.
+        constexpr std::size_t TILE_ROWS = 16;
+        constexpr std::size_t TILE_COLUMNS = 256;
+
+        template <class t_Value>
+        std::byte *copyField(std::byte *destination, const t_Value &value)
+        {
+            std::memcpy(destination, &value, sizeof(value));
+            return (destination + sizeof(value));  // NOLINT
+        }
+
+        template <class t_Value>
+        const std::byte *readField(t_Value &value, const std::byte *source, const std::byte *end)
+        {
+            SHARF_THROW_IF(
+                    static_cast<std::size_t>(end - source) < sizeof(value), "Shuffled chunk is truncated");
+            std::memcpy(&value, source, sizeof(value));
+            return (source + sizeof(value));  // NOLINT
+        }
+
+        uint64_t getRecordSize(const std::byte *record, const std::size_t available)
+        {
+            SHARF_THROW_IF(available < RECORD_HEADER_SIZE, "Malformed chunk records");
+            uint64_t length;
+            std::memcpy(&length, record + 1, sizeof(length));  // NOLINT
+            SHARF_THROW_IF(length > available - RECORD_HEADER_SIZE, "Malformed chunk records");
+            return (RECORD_HEADER_SIZE + length);
+        }
+    }  // namespace
+
+
+    void ChunkShuffler::shuffle(const std::byte *records, const std::size_t size, std::vector<std::byte> &output)
+    {
+        group_count_ = 0;
+        group_map_.clear();
+        order_.clear();
+
+        std::size_t raw_size = 0;
+        for (std::size_t offset = 0; offset < size;)
+        {
+            const std::byte *record = records + offset;  // NOLINT
+            const uint64_t record_size = getRecordSize(record, size - offset);
+
+            uint16_t group_index = RAW_RECORD;
+            if (MESSAGE_OPCODE == static_cast<uint8_t>(record[0])  // NOLINT
+                and record_size >= RECORD_HEADER_SIZE + sizeof(uint16_t)
+                and record_size <= std::numeric_limits<uint32_t>::max())
+            {
+                uint16_t channel_id;
+                std::memcpy(&channel_id, record + RECORD_HEADER_SIZE, sizeof(channel_id));  // NOLINT
+
+                const uint64_t key = (static_cast<uint64_t>(channel_id) << 32) | record_size;
+                const auto iterator = group_map_.find(key);
+                if (group_map_.end() != iterator)
+                {
+                    group_index = iterator->second;
+                }
+                else
+                {
+                    if (group_count_ < RAW_RECORD)
+                    {
+                        group_index = static_cast<uint16_t>(group_count_);
+                        group_map_.emplace(key, group_index);
+
+                        if (groups_.size() == group_count_)
+                        {
+                            groups_.emplace_back();
+                        }
+                        groups_[group_count_].row_size_ = static_cast<uint32_t>(record_size);
+                        groups_[group_count_].offsets_.clear();
+                        ++group_count_;
+                    }
+                }
+            }
+
+            if (RAW_RECORD == group_index)
+            {
+                raw_size += record_size;
+            }
+            else
+            {
+                groups_[group_index].offsets_.push_back(offset);
+            }
+            order_.push_back(group_index);
+
+            offset += record_size;
+        }
+
+
+        output.resize(
+                2 * sizeof(uint32_t) + group_count_ * 2 * sizeof(uint32_t) + order_.size() * sizeof(uint16_t) + size);
+
+        std::byte *data = output.data();
+        data = copyField(data, static_cast<uint32_t>(group_count_));
+        data = copyField(data, static_cast<uint32_t>(order_.size()));
+        for (std::size_t i = 0; i < group_count_; ++i)
+        {
+            data = copyField(data, groups_[i].row_size_);
+            data = copyField(data, static_cast<uint32_t>(groups_[i].offsets_.size()));
+        }
+        std::memcpy(data, order_.data(), order_.size() * sizeof(uint16_t));
+        data += order_.size() * sizeof(uint16_t);  // NOLINT
+
+        for (std::size_t i = 0; i < group_count_; ++i)
+        {
+            const Group &group = groups_[i];
+            const std::size_t rows = group.offsets_.size();
+
+            for (std::size_t row_begin = 0; row_begin < rows; row_begin += TILE_ROWS)
+            {
+                const std::size_t row_end = std::min(rows, row_begin + TILE_ROWS);
+
+                for (std::size_t column_begin = 0; column_begin < group.row_size_; column_begin += TILE_COLUMNS)
+                {
+                    const std::size_t column_end = std::min<std::size_t>(group.row_size_, column_begin + TILE_COLUMNS);
+
+                    for (std::size_t row = row_begin; row < row_end; ++row)
+                    {
+                        const std::byte *source = records + group.offsets_[row];  // NOLINT
+                        for (std::size_t column = column_begin; column < column_end; ++column)
+                        {
+                            data[column * rows + row] = source[column];  // NOLINT
+                        }
+                    }
+                }
+            }
+            data += rows * group.row_size_;  // NOLINT
+        }
+
+        std::byte *raw = data;
+        for (std::size_t i = 0, offset = 0; i < order_.size(); ++i)
+        {
+            const uint64_t record_size = getRecordSize(records + offset, size - offset);  // NOLINT
+            if (RAW_RECORD == order_[i])
+            {
+                std::memcpy(raw, records + offset, record_size);  // NOLINT
+                raw += record_size;                               // NOLINT
+            }
+            offset += record_size;
+        }
+    }
+
+
+    void ChunkShuffler::unshuffle(const std::byte *data, const std::size_t size, std::vector<std::byte> &records)
+    {
+        const std::byte *const end = data + size;  // NOLINT
+
+        uint32_t group_count;
+        uint32_t record_count;
+        data = readField(group_count, data, end);
+        data = readField(record_count, data, end);
+        SHARF_THROW_IF(
+                static_cast<std::size_t>(end - data) < std::size_t{ group_count } * 2 * sizeof(uint32_t),
+                "Shuffled chunk is truncated");
+
+        if (groups_.size() < group_count)
+        {
+            groups_.resize(group_count);
+        }
+
+        std::size_t records_size = 0;
+        for (std::size_t i = 0; i < group_count; ++i)
+        {
+            data = readField(groups_[i].row_size_, data, end);
+            data = readField(groups_[i].rows_, data, end);
+
+            const std::size_t group_size = static_cast<std::size_t>(groups_[i].row_size_) * groups_[i].rows_;
+            SHARF_THROW_IF(group_size > size, "Shuffled chunk is truncated");
+            records_size += group_size;
+        }
+
+        SHARF_THROW_IF(
+                static_cast<std::size_t>(end - data) < record_count * sizeof(uint16_t) + records_size,
+                "Shuffled chunk is truncated");
+        order_.resize(record_count);
+        std::memcpy(order_.data(), data, record_count * sizeof(uint16_t));
+        data += record_count * sizeof(uint16_t);  // NOLINT
+
+        // position of the next row of each group
+        rows_.resize(group_count);
+        consumed_rows_.assign(group_count, 0);
+        for (std::size_t i = 0; i < group_count; ++i)
+        {
+            rows_[i] = data;
+            data += groups_[i].row_size_ * groups_[i].rows_;  // NOLINT
+        }
+        const std::byte *raw = data;
+
+        records.resize(records_size + static_cast<std::size_t>(end - raw));
+        std::byte *output = records.data();
+        const std::byte *const output_end = records.data() + records.size();  // NOLINT
+        for (const uint16_t group_index : order_)
+        {
+            if (RAW_RECORD == group_index)
+            {
+                const uint64_t record_size = getRecordSize(raw, static_cast<std::size_t>(end - raw));
+                SHARF_THROW_IF(
+                        record_size > static_cast<std::size_t>(output_end - output), "Malformed shuffled chunk");
+                std::memcpy(output, raw, record_size);
+                raw += record_size;     // NOLINT
+                output += record_size;  // NOLINT
+            }
+            else
+            {
+                SHARF_THROW_IF(group_index >= group_count, "Malformed shuffled chunk");
+
+                const Group &group = groups_[group_index];
+                const std::size_t rows = group.rows_;
+                SHARF_THROW_IF(
+                        consumed_rows_[group_index] >= rows
+                                or group.row_size_ > static_cast<std::size_t>(output_end - output),
+                        "Malformed shuffled chunk");
+                ++consumed_rows_[group_index];
+
+                const std::byte *source = rows_[group_index];
+                for (std::size_t column = 0; column < group.row_size_; ++column)
+                {
+                    output[column] = source[column * rows];  // NOLINT
+                }
+                ++rows_[group_index];       // NOLINT
+                output += group.row_size_;  // NOLINT
+            }
+        }
+
+        SHARF_THROW_IF(output != output_end or raw != end, "Malformed shuffled chunk");
+    }
+}  // namespace pjmsg_mcap_wrapper
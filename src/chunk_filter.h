@@ -0,0 +1,61 @@
+/**
+    @file
+    @author Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace pjmsg_mcap_wrapper
+{
+    /**
+     * Chunk pre-filter which improves compression of repetitive messages:
+     * message records of the same channel and size are grouped and
+     * transposed, so that each byte of a record (e.g., the exponent byte of
+     * a particular signal) forms a contiguous column.
+     *
+     * Filtered layout (host byte order):
+     * group count (uint32) | record count (uint32) |
+     * row size (uint32), row count (uint32) for each group |
+     * group index (uint16) for each record, RAW_RECORD if not grouped |
+     * transposed records of each group | raw records.
+     */
+    class ChunkShuffler
+    {
+    public:
+        /// Prefix of MCAP compression string of filtered chunks.
+        inline static const char *const COMPRESSION_PREFIX = "shuffle+";
+
+    protected:
+        static constexpr uint16_t RAW_RECORD = 0xFFFF;
+
+        class Group
+        {
+        public:
+            uint32_t row_size_;
+            /// Offsets of rows in the chunk records, set by shuffle().
+            std::vector<uint64_t> offsets_;
+            /// Number of rows, set by unshuffle().
+            uint32_t rows_;
+        };
+
+    protected:
+        std::vector<Group> groups_;
+        std::size_t group_count_ = 0;
+        std::unordered_map<uint64_t, uint16_t> group_map_;
+        std::vector<uint16_t> order_;
+        std::vector<const std::byte *> rows_;
+        std::vector<std::size_t> consumed_rows_;
+
+    public:
+        void shuffle(const std::byte *records, const std::size_t size, std::vector<std::byte> &output);
+        void unshuffle(const std::byte *data, const std::size_t size, std::vector<std::byte> &records);
+    };
+}  // namespace pjmsg_mcap_wrapper
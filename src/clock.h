@@ -0,0 +1,217 @@
+/**
+    @file
+    @author Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#pragma once
+
+#include <time.h>
+
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#    include <cpuid.h>
+#    include <x86intrin.h>
+#    define PJMSG_MCAP_WRAPPER_TSC
+#endif
+
+
+namespace pjmsg_mcap_wrapper
+{
+    /**
+     * Source of message log timestamps, see Writer::Parameters::Clock.
+     * Relation of the clock to wall time is sampled once, when the clock is
+     * initialized, and stored in the file as metadata.
+     */
+    class Clock
+    {
+    public:
+        using Type = Writer::Parameters::Clock;
+
+    protected:
+        Type type_ = Type::SYSTEM;
+
+        uint64_t tsc_origin_ = 0;
+        uint64_t tsc_ns_origin_ = 0;
+        double tsc_period_ = 0.0;
+
+        uint64_t clock_time_ = 0;
+        uint64_t wall_time_ = 0;
+
+    protected:
+        static uint64_t getTime(const clockid_t clock_id)
+        {
+            timespec time;
+            clock_gettime(clock_id, &time);
+            return (static_cast<uint64_t>(time.tv_sec) * std::nano::den + static_cast<uint64_t>(time.tv_nsec));
+        }
+
+        static clockid_t getCoarseClockId()
+        {
+#ifdef CLOCK_MONOTONIC_COARSE
+            return (CLOCK_MONOTONIC_COARSE);
+#else
+            return (CLOCK_MONOTONIC);
+#endif
+        }
+
+#ifdef PJMSG_MCAP_WRAPPER_TSC
+        /// CPUID 0x80000007, EDX bit 8: TSC rate does not depend on
+        /// frequency scaling and power states.
+        static bool isTscInvariant()
+        {
+            unsigned int eax = 0;
+            unsigned int ebx = 0;
+            unsigned int ecx = 0;
+            unsigned int edx = 0;
+            return (0 != __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) and 0 != (edx & (1U << 8)));
+        }
+
+        /// Pair of TSC and CLOCK_MONOTONIC readings, the best of several
+        /// attempts is taken to reduce the effect of preemption.
+        static void sampleTsc(uint64_t &tsc, uint64_t &ns)
+        {
+            uint64_t best_duration = std::numeric_limits<uint64_t>::max();
+            for (std::size_t i = 0; i < 8; ++i)
+            {
+                const uint64_t begin = __rdtsc();
+                const uint64_t time = getTime(CLOCK_MONOTONIC);
+                const uint64_t end = __rdtsc();
+
+                if (end - begin < best_duration)
+                {
+                    best_duration = end - begin;
+                    tsc = begin + (end - begin) / 2;
+                    ns = time;
+                }
+            }
+        }
+
+        /**
+         * Error of the period is roughly sampling jitter divided by the
+         * calibration window, e.g., 100ns / 200ms gives drift of about 2ms
+         * per hour relative to CLOCK_MONOTONIC.
+         */
+        void calibrateTsc()
+        {
+            SHARF_THROW_IF(not isTscInvariant(), "TSC clock requires invariant TSC");
+
+            sampleTsc(tsc_origin_, tsc_ns_origin_);
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+            uint64_t tsc = 0;
+            uint64_t ns = 0;
+            sampleTsc(tsc, ns);
+
+            SHARF_THROW_IF(tsc <= tsc_origin_ or ns <= tsc_ns_origin_, "TSC clock calibration failed");
+            tsc_period_ = static_cast<double>(ns - tsc_ns_origin_) / static_cast<double>(tsc - tsc_origin_);
+        }
+#endif
+
+        static const char *getName(const Type type)
+        {
+            switch (type)
+            {
+                case Type::SYSTEM:
+                    return ("system");
+                case Type::MONOTONIC:
+                    return ("monotonic");
+                case Type::MONOTONIC_COARSE:
+                    return ("monotonic_coarse");
+                case Type::TSC:
+                    return ("tsc");
+                case Type::MESSAGE_STAMP:
+                    return ("message_stamp");
+            }
+            return ("unknown");
+        }
+
+    public:
+        void initialize(const Type type)
+        {
+            type_ = type;
+
+            if (Type::TSC == type_)
+            {
+#ifdef PJMSG_MCAP_WRAPPER_TSC
+                calibrateTsc();
+#else
+                SHARF_THROW_IF(true, "TSC clock is not supported on this platform");
+#endif
+            }
+
+            clock_time_ = now();
+            wall_time_ = getTime(CLOCK_REALTIME);
+        }
+
+        /// CLOCK_MONOTONIC_COARSE, cheap, but has resolution of a few
+        /// milliseconds.
+        [[nodiscard]] static uint64_t coarseNow()
+        {
+            return (getTime(getCoarseClockId()));
+        }
+
+        /// now() is CLOCK_MONOTONIC based: cannot jump backwards, unlike
+        /// wall time or message stamps.
+        [[nodiscard]] bool isMonotonic() const
+        {
+            return (Type::MONOTONIC == type_ or Type::MONOTONIC_COARSE == type_ or Type::TSC == type_);
+        }
+
+        /// Timestamps are taken from messages, now() falls back to system
+        /// time.
+        [[nodiscard]] bool useMessageStamp() const
+        {
+            return (Type::MESSAGE_STAMP == type_);
+        }
+
+        [[nodiscard]] uint64_t now() const
+        {
+            switch (type_)
+            {
+                case Type::MONOTONIC:
+                    return (getTime(CLOCK_MONOTONIC));
+                case Type::MONOTONIC_COARSE:
+                    return (getTime(getCoarseClockId()));
+#ifdef PJMSG_MCAP_WRAPPER_TSC
+                case Type::TSC:
+                    return (tsc_ns_origin_
+                            + static_cast<uint64_t>(static_cast<double>(__rdtsc() - tsc_origin_) * tsc_period_));
+#endif
+                case Type::SYSTEM:
+                case Type::MESSAGE_STAMP:
+                default:
+                    return (getTime(CLOCK_REALTIME));
+            }
+        }
+
+        /// wall time = log time - clock_time + wall_time
+        [[nodiscard]] mcap::Metadata getMetadata() const
+        {
+            mcap::Metadata metadata;
+            metadata.name = "pjmsg_mcap_wrapper/clock";
+            metadata.metadata.emplace("clock", getName(type_));
+            metadata.metadata.emplace("clock_time", std::to_string(clock_time_));
+            metadata.metadata.emplace("wall_time", std::to_string(wall_time_));
+            if (Type::TSC == type_)
+            {
+                metadata.metadata.emplace(
+                        "tsc_frequency", std::to_string(static_cast<uint64_t>(std::nano::den / tsc_period_)));
+
+                // nanoseconds per tick: log time = tsc_ns_origin + (TSC - tsc_origin) * tsc_period
+                std::ostringstream period;
+                period << std::setprecision(std::numeric_limits<double>::max_digits10) << tsc_period_;
+                metadata.metadata.emplace("tsc_period", period.str());
+                metadata.metadata.emplace("tsc_origin", std::to_string(tsc_origin_));
+                metadata.metadata.emplace("tsc_ns_origin", std::to_string(tsc_ns_origin_));
+            }
+            return (metadata);
+        }
+    };
+}  // namespace pjmsg_mcap_wrapper
@@ -0,0 +1,203 @@
+/**
+    @file
+    @author Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#pragma once
+
+#include <iomanip>
+#include <sstream>
+
+
+namespace pjmsg_mcap_wrapper
+{
+    /**
+     * Opens the next output file ahead of time and finalizes (summary,
+     * footer) previous files in a background thread, so that switching files
+     * costs the writing thread only a pointer swap.
+     */
+    class FileRotator
+    {
+    public:
+        /// Opens writer with the given file name.
+        using Opener = std::function<void(McapWriter &, const std::string &)>;
+
+    protected:
+        std::thread thread_;
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        std::condition_variable ready_condition_;
+        bool stop_ = false;
+
+        std::filesystem::path filename_;
+        std::size_t index_ = 0;
+        Opener opener_;
+
+        std::unique_ptr<McapWriter> next_;
+        std::string next_filename_;
+        std::deque<std::unique_ptr<McapWriter>> finished_;
+        std::exception_ptr error_;
+
+    protected:
+        void run()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+
+            for (;;)
+            {
+                condition_.wait(
+                        lock, [this]() { return (stop_ or not finished_.empty() or (not next_ and not error_)); });
+
+                std::exception_ptr error;
+
+                if (not finished_.empty())
+                {
+                    std::unique_ptr<McapWriter> writer = std::move(finished_.front());
+                    finished_.pop_front();
+
+                    lock.unlock();
+                    try
+                    {
+                        writer->close();
+                    }
+                    catch (...)
+                    {
+                        error = std::current_exception();
+                    }
+                    writer.reset();
+                    lock.lock();
+                }
+                else
+                {
+                    if (stop_)
+                    {
+                        break;
+                    }
+
+                    const std::string filename = getFilename(index_ + 1);
+                    std::unique_ptr<McapWriter> writer = std::make_unique<McapWriter>();
+
+                    lock.unlock();
+                    try
+                    {
+                        opener_(*writer, filename);
+                    }
+                    catch (...)
+                    {
+                        error = std::current_exception();
+                    }
+                    lock.lock();
+
+                    if (not error)
+                    {
+                        next_ = std::move(writer);
+                        next_filename_ = filename;
+                    }
+                }
+
+                if (error and not error_)
+                {
+                    error_ = error;
+                }
+                ready_condition_.notify_all();
+            }
+        }
+
+        /// Stop the thread and remove the prepared file.
+        void join()
+        {
+            if (not thread_.joinable())
+            {
+                return;
+            }
+
+            {
+                const std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            condition_.notify_all();
+            thread_.join();
+
+            if (next_)
+            {
+                try
+                {
+                    next_->close();
+                }
+                catch (...)
+                {
+                    // the file is discarded anyway
+                }
+                next_.reset();
+
+                std::error_code error;
+                std::filesystem::remove(next_filename_, error);
+            }
+        }
+
+    public:
+        ~FileRotator()
+        {
+            join();
+        }
+
+        /// '<stem>_<index><extension>'
+        [[nodiscard]] std::string getFilename(const std::size_t index) const
+        {
+            std::stringstream name;
+            name << filename_.stem().native() << "_" << std::setw(4) << std::setfill('0') << index
+                 << filename_.extension().native();
+            return ((filename_.parent_path() / name.str()).native());
+        }
+
+        void setFilename(const std::filesystem::path &filename)
+        {
+            filename_ = filename;
+            index_ = 0;
+        }
+
+        void start(const Opener &opener)
+        {
+            opener_ = opener;
+            stop_ = false;
+            thread_ = std::thread(&FileRotator::run, this);
+        }
+
+        /// Close remaining files, the prepared file is removed. Errors of
+        /// background operations that have not been reported by rotate()
+        /// are rethrown here.
+        void stop()
+        {
+            join();
+
+            if (error_)
+            {
+                const std::exception_ptr error = error_;
+                error_ = nullptr;
+                std::rethrow_exception(error);
+            }
+        }
+
+        /// Replace writer with the prepared one, waits if it is not ready
+        /// yet. Errors of background operations are rethrown here.
+        void rotate(std::unique_ptr<McapWriter> &writer)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_condition_.wait(lock, [this]() { return (next_ or error_); });
+            if (error_)
+            {
+                std::rethrow_exception(error_);
+            }
+
+            finished_.push_back(std::move(writer));
+            writer = std::move(next_);
+            ++index_;
+
+            lock.unlock();
+            condition_.notify_all();
+        }
+    };
+}  // namespace pjmsg_mcap_wrapper
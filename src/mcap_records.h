@@ -0,0 +1,112 @@
+/**
+    @file
+    @author Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#pragma once
+
+#include <cstdio>
+#include <cstring>
+#include <optional>
+
+namespace pjmsg_mcap_wrapper
+{
+    namespace mcap_records
+    {
+        /// opcode + length
+        constexpr std::size_t RECORD_HEADER_SIZE = 1 + 8;
+
+        using FilePtr = std::unique_ptr<std::FILE, int (*)(std::FILE *)>;
+
+        inline FilePtr openFile(const std::filesystem::path &filename)
+        {
+            FilePtr file(std::fopen(filename.c_str(), "rb"), &std::fclose);
+            SHARF_THROW_IF(nullptr == file, "Failed to open ", filename.native());
+            return (file);
+        }
+
+        /**
+         * Iterates over records packed in a decoded chunk, see
+         * visitRecords().
+         */
+        template <class t_Visitor>
+        bool visitChunkRecords(const std::vector<std::byte> &records, t_Visitor &&visitor)
+        {
+            for (std::size_t offset = 0; offset + RECORD_HEADER_SIZE <= records.size();)
+            {
+                uint64_t length;
+                std::memcpy(&length, &records[offset + 1], sizeof(length));
+                SHARF_THROW_IF(length > records.size() - offset - RECORD_HEADER_SIZE, "Malformed chunk records");
+
+                if (not visitor(
+                            static_cast<mcap::OpCode>(records[offset]), &records[offset + RECORD_HEADER_SIZE], length))
+                {
+                    return (false);
+                }
+                offset += RECORD_HEADER_SIZE + length;
+            }
+            return (true);
+        }
+
+        /**
+         * Iterates over data section records of a recording, visitor is
+         * called with opcode and content of records found at the top level
+         * and in chunks, stops when visitor returns false. Chunks are
+         * decoded with the given decoder. Records can be limited to
+         * [begin, end) file offsets, which must point to top level records.
+         */
+        template <class t_Visitor>
+        void visitRecords(
+                const std::filesystem::path &recording,
+                ChunkDecoder &decoder,
+                t_Visitor &&visitor,
+                const uint64_t begin = sizeof(mcap::Magic),
+                const uint64_t end = mcap::EndOffset)
+        {
+            const FilePtr file = openFile(recording);
+            mcap::FileReader input(file.get());
+            mcap::RecordReader reader(input, begin, end);
+
+            for (std::optional<mcap::Record> record = reader.next(); record; record = reader.next())
+            {
+                switch (record->opcode)
+                {
+                    case mcap::OpCode::DataEnd:
+                    case mcap::OpCode::Footer:
+                        return;
+
+                    case mcap::OpCode::Chunk:
+                    {
+                        mcap::Chunk chunk;
+                        const mcap::Status status = mcap::McapReader::ParseChunk(*record, &chunk);
+                        SHARF_THROW_IF(not status.ok(), "Failed to parse chunk: ", status.message);
+
+                        if (not visitChunkRecords(
+                                    decoder.decode(
+                                            chunk.compression,
+                                            chunk.records,
+                                            chunk.compressedSize,
+                                            chunk.uncompressedSize),
+                                    visitor))
+                        {
+                            return;
+                        }
+                        break;
+                    }
+
+                    default:
+                        if (not visitor(record->opcode, record->data, record->dataSize))
+                        {
+                            return;
+                        }
+                        break;
+                }
+            }
+
+            SHARF_THROW_IF(not reader.status().ok(), "Failed to read ", recording.native(), ": ", reader.status().message);
+        }
+    }  // namespace mcap_records
+}  // namespace pjmsg_mcap_wrapper
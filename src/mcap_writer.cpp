@@ -0,0 +1,1401 @@
+/**
+    @file
+    @author Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#include "3rdparty.h"
+#include "util.h"
+#include "mcap_writer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include <mcap/crc32.hpp>
+#include <mcap/internal.hpp>
+#include <lz4frame.h>
+#include <lz4hc.h>
+#include <zstd.h>
+
+
+namespace
+{
+    // same as in mcap::McapWriter
+    /// Both LZ4 and ZSTD recommend ~1KB as the minimum size for compressed data
+    constexpr uint64_t MIN_COMPRESSION_SIZE = 1024;
+    /// Throw away any compression results that save less than 2% of the original size
+    constexpr double MIN_COMPRESSION_RATIO = 1.02;
+
+    /// Adaptive compression: lower level if compression takes more than this
+    /// fraction of chunk fill time, raise if less than ADAPTIVE_LOW_LOAD.
+    constexpr double ADAPTIVE_HIGH_LOAD = 0.8;
+    constexpr double ADAPTIVE_LOW_LOAD = 0.2;
+
+    /// Streaming compression: records are compressed and flushed as a ZSTD
+    /// block once this many bytes accumulate, which bounds the work done by
+    /// a single write; smaller blocks compress worse.
+    constexpr uint64_t STREAM_STEP_SIZE = 32 * 1024;
+
+    uint64_t getSteadyTime()
+    {
+        return (static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+                        .count()));
+    }
+
+    int getZstdCompressionLevel(const mcap::CompressionLevel level)
+    {
+        switch (level)
+        {
+            case mcap::CompressionLevel::Fastest:
+                return (-5);
+            case mcap::CompressionLevel::Fast:
+                return (-3);
+            case mcap::CompressionLevel::Slow:
+                return (5);
+            case mcap::CompressionLevel::Slowest:
+                return (19);
+            case mcap::CompressionLevel::Default:
+            default:
+                return (1);
+        }
+    }
+
+    // same as in mcap::McapWriter
+    int getLz4CompressionLevel(const mcap::CompressionLevel level)
+    {
+        switch (level)
+        {
+            case mcap::CompressionLevel::Fastest:
+                return (-1);
+            case mcap::CompressionLevel::Fast:
+                return (0);
+            case mcap::CompressionLevel::Slow:
+                return (LZ4HC_CLEVEL_OPT_MIN);
+            case mcap::CompressionLevel::Slowest:
+                return (LZ4HC_CLEVEL_MAX);
+            case mcap::CompressionLevel::Default:
+            default:
+                return (LZ4HC_CLEVEL_DEFAULT);
+        }
+    }
+
+    template <class t_Value>
+    std::byte *copyField(std::byte *destination, const t_Value &value)
+    {
+        std::memcpy(destination, &value, sizeof(value));
+        return (destination + sizeof(value));  // NOLINT
+    }
+}  // namespace
+
+
+namespace pjmsg_mcap_wrapper
+{
+    RecordBuffer::RecordBuffer()
+    {
+        clear();
+    }
+
+    void RecordBuffer::end()
+    {
+    }
+
+    uint64_t RecordBuffer::size() const
+    {
+        return (size_);
+    }
+
+    const std::byte *RecordBuffer::data() const
+    {
+        return (data_.get());
+    }
+
+    bool RecordBuffer::empty() const
+    {
+        return (0 == size_);
+    }
+
+    void RecordBuffer::reserve(const std::size_t capacity)
+    {
+        if (capacity > capacity_)
+        {
+            std::unique_ptr<std::byte[]> data(new std::byte[capacity]);  // NOLINT
+            if (size_ > 0)
+            {
+                std::memcpy(data.get(), data_.get(), size_);
+            }
+            data_ = std::move(data);
+            capacity_ = capacity;
+        }
+    }
+
+    void RecordBuffer::clear()
+    {
+        size_ = 0;
+        checksum_ = mcap::internal::CRC32_INIT;
+    }
+
+    std::byte *RecordBuffer::append(const std::size_t size)
+    {
+        if (size_ + size > capacity_)
+        {
+            reserve(std::max(size_ + size, 2 * capacity_));
+        }
+
+        std::byte *result = data_.get() + size_;
+        size_ += size;
+        return (result);
+    }
+
+    void RecordBuffer::updateChecksum(const std::byte *data, const std::size_t size)
+    {
+        if (checksum_enabled_)
+        {
+            checksum_ = mcap::internal::crc32Update(checksum_, data, size);
+        }
+    }
+
+    uint32_t RecordBuffer::checksum() const
+    {
+        return (checksum_enabled_ ? mcap::internal::crc32Final(checksum_) : 0);
+    }
+
+    void RecordBuffer::handleWrite(const std::byte *data, uint64_t size)
+    {
+        std::byte *destination = append(size);
+        std::memcpy(destination, data, size);
+        updateChecksum(destination, size);
+    }
+}  // namespace pjmsg_mcap_wrapper
+
+
+namespace pjmsg_mcap_wrapper
+{
+    Chunk::Chunk()
+    {
+        clear();
+    }
+
+    void Chunk::clear()
+    {
+        records_.clear();
+        compressed_.clear();
+        for (mcap::MessageIndex &message_index : message_indices_)
+        {
+            message_index.records.clear();
+        }
+        start_time_ = mcap::MaxTime;
+        end_time_ = 0;
+        compression_ = mcap::Compression::None;
+        shuffled_ = false;
+        ready_ = false;
+        message_count_ = 0;
+        channel_message_counts_.clear();
+        fill_start_ = 0;
+        fill_duration_ = 0;
+        stream_input_size_ = 0;
+        stream_output_size_ = 0;
+        stream_duration_ = 0;
+    }
+
+    bool Chunk::empty() const
+    {
+        return (records_.empty());
+    }
+
+    const std::byte *Chunk::data() const
+    {
+        return (mcap::Compression::None == compression_ ? records_.data() : compressed_.data());
+    }
+
+    uint64_t Chunk::dataSize() const
+    {
+        return (mcap::Compression::None == compression_ ? records_.size() : compressed_.size());
+    }
+}  // namespace pjmsg_mcap_wrapper
+
+
+namespace pjmsg_mcap_wrapper
+{
+    ChunkCompressor::ChunkCompressor(const McapWriterParameters &params)
+    {
+        const mcap::McapWriterOptions &options = params.options_;
+        const std::vector<std::byte> &zstd_dictionary = params.zstd_dictionary_;
+
+        compression_ = options.compression;
+        force_ = options.forceCompression;
+        shuffle_ = params.shuffle_;
+        zstd_context_ = nullptr;
+        zstd_level_ = getZstdCompressionLevel(options.compressionLevel);
+        lz4_context_ = nullptr;
+        lz4_level_ = getLz4CompressionLevel(options.compressionLevel);
+        streaming_ = params.streaming_compression_ and mcap::Compression::Zstd == compression_ and not shuffle_;
+        stream_chunk_ = nullptr;
+        adaptive_ = params.adaptive_compression_ and mcap::Compression::Zstd == compression_;
+        // chunks are compressed in parallel
+        fill_time_scale_ = static_cast<double>(std::max<std::size_t>(1, params.compression_threads_));
+
+        switch (compression_)
+        {
+            case mcap::Compression::Zstd:
+                zstd_context_ = ZSTD_createCCtx();
+                SHARF_THROW_IF(nullptr == zstd_context_, "Failed to create ZSTD context");
+                ZSTD_CCtx_setParameter(zstd_context_, ZSTD_c_compressionLevel, zstd_level_);
+                if (not zstd_dictionary.empty())
+                {
+                    const std::size_t result =
+                            ZSTD_CCtx_loadDictionary(zstd_context_, zstd_dictionary.data(), zstd_dictionary.size());
+                    SHARF_THROW_IF(
+                            ZSTD_isError(result), "Failed to load ZSTD dictionary: ", ZSTD_getErrorName(result));
+                }
+                break;
+
+            case mcap::Compression::Lz4:
+            {
+                const LZ4F_errorCode_t error = LZ4F_createCompressionContext(&lz4_context_, LZ4F_VERSION);
+                SHARF_THROW_IF(LZ4F_isError(error), "Failed to create LZ4 context: ", LZ4F_getErrorName(error));
+                break;
+            }
+
+            case mcap::Compression::None:
+                break;
+
+            default:
+                throw std::runtime_error("Unsupported compression type");
+        }
+    }
+
+    ChunkCompressor::~ChunkCompressor()
+    {
+        ZSTD_freeCCtx(zstd_context_);
+        LZ4F_freeCompressionContext(lz4_context_);
+    }
+
+    void ChunkCompressor::compress(Chunk &chunk)
+    {
+        chunk.compression_ = mcap::Compression::None;
+        chunk.shuffled_ = false;
+
+        const RecordBuffer &records = chunk.records_;
+        if (mcap::Compression::None == compression_)
+        {
+            return;
+        }
+
+        const uint64_t start_time = adaptive_ ? getSteadyTime() : 0;
+        std::size_t size = 0;
+        if (streaming_)
+        {
+            // the frame must be finalized even if it is not going to be used
+            size = streamZstd(chunk, /*end=*/true);
+            stream_chunk_ = nullptr;
+        }
+        else
+        {
+            if (not force_ and records.size() < MIN_COMPRESSION_SIZE)
+            {
+                return;
+            }
+
+            const std::byte *input = records.data();
+            std::size_t input_size = records.size();
+            if (shuffle_)
+            {
+                shuffler_.shuffle(records.data(), records.size(), shuffled_);
+                input = shuffled_.data();
+                input_size = shuffled_.size();
+            }
+
+            size = mcap::Compression::Lz4 == compression_ ? compressLz4(chunk, input, input_size)
+                                                          : compressZstd(chunk, input, input_size);
+        }
+        chunk.compressed_.resize(size);
+        if (adaptive_)
+        {
+            adaptLevel(chunk.fill_duration_, getSteadyTime() - start_time + chunk.stream_duration_);
+        }
+
+        if (not force_ and records.size() < MIN_COMPRESSION_SIZE)
+        {
+            return;
+        }
+
+        if (force_
+            or static_cast<double>(records.size()) / static_cast<double>(size) >= MIN_COMPRESSION_RATIO)
+        {
+            chunk.compression_ = compression_;
+            chunk.shuffled_ = shuffle_;
+        }
+    }
+
+    std::size_t ChunkCompressor::compressZstd(Chunk &chunk, const std::byte *input, const std::size_t input_size)
+    {
+        chunk.compressed_.resize(ZSTD_compressBound(input_size));
+        const std::size_t size =
+                ZSTD_compress2(zstd_context_, chunk.compressed_.data(), chunk.compressed_.size(), input, input_size);
+        SHARF_THROW_IF(ZSTD_isError(size), "ZSTD compression failed: ", ZSTD_getErrorName(size));
+        return (size);
+    }
+
+    void ChunkCompressor::feed(Chunk &chunk)
+    {
+        if (streaming_ and chunk.records_.size() - chunk.stream_input_size_ >= STREAM_STEP_SIZE)
+        {
+            const uint64_t start_time = adaptive_ ? getSteadyTime() : 0;
+            streamZstd(chunk, /*end=*/false);
+            if (adaptive_)
+            {
+                chunk.stream_duration_ += getSteadyTime() - start_time;
+            }
+        }
+    }
+
+    std::size_t ChunkCompressor::streamZstd(Chunk &chunk, const bool end)
+    {
+        if (&chunk != stream_chunk_)
+        {
+            // context holds a frame of another chunk, e.g., when a chunk is
+            // set aside in McapWriter::trigger(), start over
+            ZSTD_CCtx_reset(zstd_context_, ZSTD_reset_session_only);
+            chunk.stream_input_size_ = 0;
+            chunk.stream_output_size_ = 0;
+            stream_chunk_ = &chunk;
+        }
+
+        const RecordBuffer &records = chunk.records_;
+        ZSTD_inBuffer input{ records.data() + chunk.stream_input_size_,  // NOLINT
+                             records.size() - chunk.stream_input_size_,
+                             0 };
+
+        for (;;)
+        {
+            // ZSTD emits at most a block per call when input is not flushed,
+            // the buffer grows only for the first few chunks
+            if (chunk.compressed_.size() - chunk.stream_output_size_ < ZSTD_CStreamOutSize())
+            {
+                chunk.compressed_.resize(std::max(
+                        2 * chunk.compressed_.size(), chunk.stream_output_size_ + ZSTD_CStreamOutSize()));
+            }
+
+            ZSTD_outBuffer output{ chunk.compressed_.data(), chunk.compressed_.size(), chunk.stream_output_size_ };
+            const std::size_t remaining =
+                    ZSTD_compressStream2(zstd_context_, &output, &input, end ? ZSTD_e_end : ZSTD_e_flush);
+            SHARF_THROW_IF(ZSTD_isError(remaining), "ZSTD compression failed: ", ZSTD_getErrorName(remaining));
+            chunk.stream_output_size_ = output.pos;
+
+            if (end ? 0 == remaining : input.pos == input.size)
+            {
+                break;
+            }
+        }
+        chunk.stream_input_size_ = records.size();
+
+        return (chunk.stream_output_size_);
+    }
+
+    void ChunkCompressor::adaptLevel(const uint64_t fill_duration, const uint64_t compression_duration)
+    {
+        if (0 == fill_duration)
+        {
+            return;
+        }
+
+        const double load = static_cast<double>(compression_duration)
+                            / (static_cast<double>(fill_duration) * fill_time_scale_);
+
+        int level = zstd_level_;
+        if (load > ADAPTIVE_HIGH_LOAD)
+        {
+            level = std::max(getZstdCompressionLevel(mcap::CompressionLevel::Fastest), level - 1);
+        }
+        else if (load < ADAPTIVE_LOW_LOAD)
+        {
+            level = std::min(getZstdCompressionLevel(mcap::CompressionLevel::Slowest), level + 1);
+        }
+
+        if (0 == level)
+        {
+            // 0 selects the default level
+            level = level > zstd_level_ ? 1 : -1;
+        }
+
+        if (level != zstd_level_)
+        {
+            zstd_level_ = level;
+            const std::size_t result = ZSTD_CCtx_setParameter(zstd_context_, ZSTD_c_compressionLevel, zstd_level_);
+            SHARF_THROW_IF(ZSTD_isError(result), "Failed to set ZSTD level: ", ZSTD_getErrorName(result));
+        }
+    }
+
+    std::size_t ChunkCompressor::compressLz4(Chunk &chunk, const std::byte *input, const std::size_t input_size)
+    {
+        // same as LZ4F_compressFrame(), but reuses the context
+        LZ4F_preferences_t preferences = LZ4F_INIT_PREFERENCES;
+        preferences.compressionLevel = lz4_level_;
+        // needed to decompress filtered chunks, see ChunkDecoder
+        preferences.frameInfo.contentSize = input_size;
+
+        chunk.compressed_.resize(LZ4F_compressFrameBound(input_size, &preferences));
+        std::byte *output = chunk.compressed_.data();
+        std::size_t capacity = chunk.compressed_.size();
+
+        std::size_t size = LZ4F_compressBegin(lz4_context_, output, capacity, &preferences);
+        SHARF_THROW_IF(LZ4F_isError(size), "LZ4 compression failed: ", LZ4F_getErrorName(size));
+        std::size_t total_size = size;
+
+        size = LZ4F_compressUpdate(
+                lz4_context_, output + total_size, capacity - total_size, input, input_size, nullptr);  // NOLINT
+        SHARF_THROW_IF(LZ4F_isError(size), "LZ4 compression failed: ", LZ4F_getErrorName(size));
+        total_size += size;
+
+        size = LZ4F_compressEnd(lz4_context_, output + total_size, capacity - total_size, nullptr);  // NOLINT
+        SHARF_THROW_IF(LZ4F_isError(size), "LZ4 compression failed: ", LZ4F_getErrorName(size));
+        total_size += size;
+
+        return (total_size);
+    }
+}  // namespace pjmsg_mcap_wrapper
+
+
+namespace pjmsg_mcap_wrapper
+{
+    CompressionPool::~CompressionPool()
+    {
+        stop();
+    }
+
+    void CompressionPool::run(const McapWriterParameters &params)
+    {
+        ChunkCompressor compressor(params);
+
+        for (;;)
+        {
+            Chunk *chunk = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                pending_condition_.wait(lock, [this] { return (stop_ or not pending_.empty()); });
+                if (pending_.empty())
+                {
+                    return;
+                }
+                chunk = pending_.front();
+                pending_.pop_front();
+            }
+
+            compressor.compress(*chunk);
+
+            {
+                const std::lock_guard<std::mutex> lock(mutex_);
+                chunk->ready_ = true;
+            }
+            ready_condition_.notify_all();
+        }
+    }
+
+    void CompressionPool::start(const McapWriterParameters &params)
+    {
+        stop();
+
+        stop_ = false;
+        threads_.reserve(params.compression_threads_);
+        for (std::size_t i = 0; i < params.compression_threads_; ++i)
+        {
+            threads_.emplace_back(&CompressionPool::run, this, std::cref(params));
+        }
+    }
+
+    void CompressionPool::stop()
+    {
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        pending_condition_.notify_all();
+
+        for (std::thread &thread : threads_)
+        {
+            thread.join();
+        }
+        threads_.clear();
+    }
+
+    std::size_t CompressionPool::size() const
+    {
+        return (threads_.size());
+    }
+
+    void CompressionPool::push(Chunk &chunk)
+    {
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            chunk.ready_ = false;
+            pending_.push_back(&chunk);
+        }
+        pending_condition_.notify_one();
+    }
+
+    void CompressionPool::wait(Chunk &chunk)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_condition_.wait(lock, [&chunk] { return (chunk.ready_); });
+    }
+
+    bool CompressionPool::ready(Chunk &chunk)
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        return (chunk.ready_);
+    }
+}  // namespace pjmsg_mcap_wrapper
+
+
+namespace pjmsg_mcap_wrapper
+{
+    McapWriterParameters::McapWriterParameters() : options_("ros2msg")
+    {
+        compression_threads_ = 0;
+        shuffle_ = false;
+        adaptive_compression_ = false;
+        streaming_compression_ = false;
+        max_chunk_latency_ = 0;
+        ring_size_ = 0;
+        ring_duration_ = 0;
+    }
+
+
+    McapWriter::~McapWriter()
+    {
+        try
+        {
+            close();
+        }
+        catch (...)
+        {
+            // errors are reported by explicit close()
+        }
+    }
+
+    void McapWriter::open(const std::string_view &filename, const Parameters &params)
+    {
+        close();
+
+        params_ = params;
+        if (params_.options_.noChunking)
+        {
+            params_.options_.compression = mcap::Compression::None;
+        }
+        recording_ = params_.ring_size_ > 0 or params_.ring_duration_ > 0;
+        SHARF_THROW_IF(recording_ and params_.options_.noChunking, "Flight recorder mode requires chunking");
+        SHARF_THROW_IF(
+                params_.streaming_compression_ and params_.shuffle_,
+                "Streaming compression is not compatible with chunk shuffling");
+
+        const mcap::Status res = file_.open(filename);
+        SHARF_THROW_IF(not res.ok(), "Failed to open ", filename, " for writing: ", res.message);
+        file_.crcEnabled = params_.options_.enableDataCRC;
+        file_.resetCrc();
+
+        statistics_ = mcap::Statistics{};
+        chunk_indices_.clear();
+        attachment_indices_.clear();
+        metadata_indices_.clear();
+        written_schemas_.assign(schemas_.size(), false);
+        written_channels_.assign(channels_.size(), false);
+
+        if (not params_.options_.noChunking)
+        {
+            chunk_ = getFreeChunk();
+
+            if (params_.compression_threads_ > 0 and mcap::Compression::None != params_.options_.compression)
+            {
+                pool_.start(params_);
+            }
+            else
+            {
+                compressor_ = std::make_unique<ChunkCompressor>(params_);
+            }
+        }
+
+        opened_ = true;
+
+        mcap::McapWriter::writeMagic(file_);
+        mcap::McapWriter::write(file_, mcap::Header{ params_.options_.profile, params_.options_.library });
+
+        if (mcap::Compression::Zstd == params_.options_.compression and not params_.zstd_dictionary_.empty())
+        {
+            // before chunks, so that the file can be decompressed in one pass
+            mcap::Attachment attachment;
+            attachment.logTime = 0;
+            attachment.createTime = 0;
+            attachment.name = ZSTD_DICTIONARY_ATTACHMENT;
+            attachment.mediaType = "application/octet-stream";
+            attachment.dataSize = params_.zstd_dictionary_.size();
+            attachment.data = params_.zstd_dictionary_.data();
+            write(attachment);
+        }
+    }
+
+
+    void McapWriter::close()
+    {
+        if (not opened_)
+        {
+            return;
+        }
+
+        closeLastChunk();
+        pool_.stop();
+        compressor_.reset();
+        chunk_.reset();
+        free_chunks_.clear();
+        // never triggered
+        ring_.clear();
+        ring_bytes_ = 0;
+        recording_ = false;
+
+        const mcap::McapWriterOptions &options = params_.options_;
+
+        mcap::McapWriter::write(file_, mcap::DataEnd{ file_.crc() });
+        if (not options.noSummaryCRC)
+        {
+            file_.crcEnabled = true;
+            file_.resetCrc();
+        }
+
+        mcap::ByteOffset summary_start = 0;
+        mcap::ByteOffset summary_offset_start = 0;
+
+        if (not options.noSummary)
+        {
+            summary_start = file_.size();
+
+            const mcap::ByteOffset schema_start = file_.size();
+            bool has_schemas = false;
+            if (not options.noRepeatedSchemas)
+            {
+                for (std::size_t i = 0; i < schemas_.size(); ++i)
+                {
+                    if (written_schemas_[i])
+                    {
+                        mcap::McapWriter::write(file_, schemas_[i]);
+                        has_schemas = true;
+                    }
+                }
+            }
+
+            const mcap::ByteOffset channel_start = file_.size();
+            bool has_channels = false;
+            if (not options.noRepeatedChannels)
+            {
+                for (std::size_t i = 0; i < channels_.size(); ++i)
+                {
+                    if (written_channels_[i])
+                    {
+                        mcap::McapWriter::write(file_, channels_[i]);
+                        has_channels = true;
+                    }
+                }
+            }
+
+            const mcap::ByteOffset statistics_start = file_.size();
+            if (not options.noStatistics)
+            {
+                mcap::McapWriter::write(file_, statistics_);
+            }
+
+            const mcap::ByteOffset chunk_index_start = file_.size();
+            if (not options.noChunkIndex)
+            {
+                for (const mcap::ChunkIndex &chunk_index : chunk_indices_)
+                {
+                    mcap::McapWriter::write(file_, chunk_index);
+                }
+            }
+
+            const mcap::ByteOffset attachment_index_start = file_.size();
+            if (not options.noAttachmentIndex)
+            {
+                for (const mcap::AttachmentIndex &attachment_index : attachment_indices_)
+                {
+                    mcap::McapWriter::write(file_, attachment_index);
+                }
+            }
+
+            const mcap::ByteOffset metadata_index_start = file_.size();
+            if (not options.noMetadataIndex)
+            {
+                for (const mcap::MetadataIndex &metadata_index : metadata_indices_)
+                {
+                    mcap::McapWriter::write(file_, metadata_index);
+                }
+            }
+
+            const mcap::ByteOffset metadata_index_end = file_.size();
+
+            if (not options.noSummaryOffsets)
+            {
+                summary_offset_start = file_.size();
+
+                if (has_schemas)
+                {
+                    mcap::McapWriter::write(
+                            file_,
+                            mcap::SummaryOffset{ mcap::OpCode::Schema, schema_start, channel_start - schema_start });
+                }
+                if (has_channels)
+                {
+                    mcap::McapWriter::write(
+                            file_,
+                            mcap::SummaryOffset{
+                                    mcap::OpCode::Channel, channel_start, statistics_start - channel_start });
+                }
+                if (not options.noStatistics)
+                {
+                    mcap::McapWriter::write(
+                            file_,
+                            mcap::SummaryOffset{
+                                    mcap::OpCode::Statistics, statistics_start, chunk_index_start - statistics_start });
+                }
+                if (not options.noChunkIndex and not chunk_indices_.empty())
+                {
+                    mcap::McapWriter::write(
+                            file_,
+                            mcap::SummaryOffset{ mcap::OpCode::ChunkIndex,
+                                                 chunk_index_start,
+                                                 attachment_index_start - chunk_index_start });
+                }
+                if (not options.noAttachmentIndex and not attachment_indices_.empty())
+                {
+                    mcap::McapWriter::write(
+                            file_,
+                            mcap::SummaryOffset{ mcap::OpCode::AttachmentIndex,
+                                                 attachment_index_start,
+                                                 metadata_index_start - attachment_index_start });
+                }
+                if (not options.noMetadataIndex and not metadata_indices_.empty())
+                {
+                    mcap::McapWriter::write(
+                            file_,
+                            mcap::SummaryOffset{ mcap::OpCode::MetadataIndex,
+                                                 metadata_index_start,
+                                                 metadata_index_end - metadata_index_start });
+                }
+            }
+            else if (summary_start == file_.size())
+            {
+                summary_start = 0;
+            }
+        }
+
+        mcap::McapWriter::write(
+                file_, mcap::Footer{ summary_start, summary_offset_start }, not options.noSummaryCRC);
+        mcap::McapWriter::writeMagic(file_);
+
+        file_.end();
+        opened_ = false;
+    }
+
+
+    void McapWriter::addSchema(mcap::Schema &schema)
+    {
+        schema.id = static_cast<mcap::SchemaId>(schemas_.size() + 1);
+        schemas_.push_back(schema);
+        written_schemas_.push_back(false);
+    }
+
+    void McapWriter::addChannel(mcap::Channel &channel)
+    {
+        channel.id = static_cast<mcap::ChannelId>(channels_.size() + 1);
+        channels_.push_back(channel);
+        written_channels_.push_back(false);
+
+        if (chunk_)
+        {
+            chunk_->message_indices_.resize(channels_.size());
+        }
+    }
+
+
+    void McapWriter::copyDefinitions(const McapWriter &other)
+    {
+        SHARF_THROW_IF(opened_, "Definitions must be copied before opening");
+
+        schemas_ = other.schemas_;
+        channels_ = other.channels_;
+        written_schemas_.assign(schemas_.size(), false);
+        written_channels_.assign(channels_.size(), false);
+    }
+
+
+    uint64_t McapWriter::fileSize() const
+    {
+        return (file_.size());
+    }
+
+
+    uint64_t McapWriter::getChunkSequence(const mcap::Message &message) const
+    {
+        if (chunk_ and not chunk_->empty()
+            and 9 + mcap::McapWriter::getRecordSize(message) + chunk_->records_.size() >= params_.options_.chunkSize)
+        {
+            // see reserveMessages()
+            return (chunk_sequence_ + 1);
+        }
+        return (chunk_sequence_);
+    }
+
+
+    mcap::IWritable &McapWriter::getOutput()
+    {
+        if (chunk_)
+        {
+            return (chunk_->records_);
+        }
+        return (file_);
+    }
+
+
+    void McapWriter::updateStatistics(const mcap::Message &message, const std::size_t count, const uint64_t *log_times)
+    {
+        mcap::Timestamp start_time = message.logTime;
+        mcap::Timestamp end_time = message.logTime;
+        if (nullptr != log_times)
+        {
+            const auto [min, max] = std::minmax_element(log_times, log_times + count);  // NOLINT
+            start_time = *min;
+            end_time = *max;
+        }
+
+        if (0 == statistics_.messageCount)
+        {
+            statistics_.messageStartTime = start_time;
+            statistics_.messageEndTime = end_time;
+        }
+        else
+        {
+            statistics_.messageStartTime = std::min(statistics_.messageStartTime, start_time);
+            statistics_.messageEndTime = std::max(statistics_.messageEndTime, end_time);
+        }
+        statistics_.messageCount += count;
+        statistics_.channelMessageCounts[message.channelId] += count;
+    }
+
+
+    uint64_t McapWriter::beginMessages(
+            const mcap::Message &message,
+            const std::size_t count,
+            const uint64_t *log_times)
+    {
+        SHARF_THROW_IF(not opened_, "Writer is not open");
+
+        const std::size_t channel_index = message.channelId - 1;
+        SHARF_THROW_IF(channel_index >= channels_.size(), "Invalid channel id");
+
+        if (not written_channels_[channel_index])
+        {
+            const mcap::Channel &channel = channels_[channel_index];
+
+            if (0 != channel.schemaId and not written_schemas_[channel.schemaId - 1])
+            {
+                mcap::McapWriter::write(getOutput(), schemas_[channel.schemaId - 1]);
+                written_schemas_[channel.schemaId - 1] = true;
+                ++statistics_.schemaCount;
+            }
+
+            mcap::McapWriter::write(getOutput(), channel);
+            written_channels_[channel_index] = true;
+            statistics_.channelMessageCounts.emplace(message.channelId, 0);
+            ++statistics_.channelCount;
+        }
+
+        if (count > 0 and not params_.options_.noSummary and not recording_)
+        {
+            updateStatistics(message, count, log_times);
+        }
+
+        return (9 + mcap::McapWriter::getRecordSize(message));
+    }
+
+
+    std::byte *McapWriter::reserveMessages(
+            const mcap::Message &message,
+            const uint64_t record_size,
+            std::size_t &count,
+            const uint64_t *log_times)
+    {
+        if (not chunk_)
+        {
+            scratch_.clear();
+            scratch_.reserve(count * record_size);
+            return (scratch_.append(count * record_size));
+        }
+
+        const uint64_t chunk_size = params_.options_.chunkSize;
+
+        // close the chunk before a message that would overflow it
+        if (not chunk_->empty() and record_size + chunk_->records_.size() >= chunk_size)
+        {
+            closeChunk();
+        }
+
+        if (params_.adaptive_compression_ and 0 == chunk_->fill_start_)
+        {
+            chunk_->fill_start_ = getSteadyTime();
+        }
+
+        const uint64_t free_space = chunk_size - std::min(chunk_size, chunk_->records_.size() + 1);
+        count = std::max<std::size_t>(1, std::min<std::size_t>(count, free_space / record_size));
+
+        uint64_t offset = chunk_->records_.size();
+        if (not params_.options_.noMessageIndex)
+        {
+            mcap::MessageIndex &message_index = chunk_->message_indices_[message.channelId - 1];
+            message_index.channelId = message.channelId;
+            for (std::size_t i = 0; i < count; ++i, offset += record_size)
+            {
+                message_index.records.emplace_back(nullptr == log_times ? message.logTime : log_times[i], offset);
+            }
+        }
+        if (nullptr == log_times)
+        {
+            chunk_->start_time_ = std::min(chunk_->start_time_, message.logTime);
+            chunk_->end_time_ = std::max(chunk_->end_time_, message.logTime);
+        }
+        else
+        {
+            const auto [min, max] = std::minmax_element(log_times, log_times + count);  // NOLINT
+            chunk_->start_time_ = std::min(chunk_->start_time_, *min);
+            chunk_->end_time_ = std::max(chunk_->end_time_, *max);
+        }
+
+        if (recording_)
+        {
+            chunk_->message_count_ += count;
+            chunk_->channel_message_counts_[message.channelId] += count;
+        }
+
+        return (chunk_->records_.append(count * record_size));
+    }
+
+
+    void McapWriter::writeMessagePrefix(
+            std::byte *record,
+            const mcap::Message &message,
+            const mcap::Timestamp log_time,
+            const mcap::Timestamp publish_time)
+    {
+        const mcap::OpCode opcode = mcap::OpCode::Message;
+        const uint64_t record_size = mcap::McapWriter::getRecordSize(message);
+
+        record = copyField(record, opcode);
+        record = copyField(record, record_size);
+        record = copyField(record, message.channelId);
+        record = copyField(record, message.sequence);
+        record = copyField(record, log_time);
+        copyField(record, publish_time);
+    }
+
+
+    void McapWriter::commitMessages(const std::byte *records, const std::size_t size)
+    {
+        if (chunk_)
+        {
+            chunk_->records_.updateChecksum(records, size);
+            if (compressor_)
+            {
+                compressor_->feed(*chunk_);
+            }
+
+            if (chunk_->records_.size() >= params_.options_.chunkSize)
+            {
+                closeChunk();
+            }
+        }
+        else
+        {
+            file_.write(records, size);
+        }
+    }
+
+
+    void McapWriter::write(const mcap::Message &message)
+    {
+        write(message, [&message](std::byte *payload) { std::memcpy(payload, message.data, message.dataSize); });
+    }
+
+
+    void McapWriter::write(const mcap::Metadata &metadata)
+    {
+        SHARF_THROW_IF(not opened_, "Writer is not open");
+
+        const uint64_t offset = file_.size();
+        mcap::McapWriter::write(file_, metadata);
+
+        if (not params_.options_.noSummary)
+        {
+            ++statistics_.metadataCount;
+            if (not params_.options_.noMetadataIndex)
+            {
+                metadata_indices_.emplace_back(metadata, offset);
+            }
+        }
+    }
+
+
+    void McapWriter::write(mcap::Attachment &attachment)
+    {
+        SHARF_THROW_IF(not opened_, "Writer is not open");
+
+        attachment.crc = 0;
+        if (not params_.options_.noAttachmentCRC)
+        {
+            // same as in mcap::McapWriter
+            const uint32_t name_size = static_cast<uint32_t>(attachment.name.size());
+            const uint32_t media_type_size = static_cast<uint32_t>(attachment.mediaType.size());
+
+            uint32_t crc = mcap::internal::CRC32_INIT;
+            crc = mcap::internal::crc32Update(
+                    crc, reinterpret_cast<const std::byte *>(&attachment.logTime), 8);  // NOLINT
+            crc = mcap::internal::crc32Update(
+                    crc, reinterpret_cast<const std::byte *>(&attachment.createTime), 8);         // NOLINT
+            crc = mcap::internal::crc32Update(crc, reinterpret_cast<const std::byte *>(&name_size), 4);  // NOLINT
+            crc = mcap::internal::crc32Update(
+                    crc, reinterpret_cast<const std::byte *>(attachment.name.data()), name_size);  // NOLINT
+            crc = mcap::internal::crc32Update(
+                    crc, reinterpret_cast<const std::byte *>(&media_type_size), 4);  // NOLINT
+            crc = mcap::internal::crc32Update(
+                    crc, reinterpret_cast<const std::byte *>(attachment.mediaType.data()), media_type_size);  // NOLINT
+            crc = mcap::internal::crc32Update(
+                    crc, reinterpret_cast<const std::byte *>(&attachment.dataSize), 8);  // NOLINT
+            crc = mcap::internal::crc32Update(crc, attachment.data, attachment.dataSize);
+            attachment.crc = mcap::internal::crc32Final(crc);
+        }
+
+        const uint64_t offset = file_.size();
+        mcap::McapWriter::write(file_, attachment);
+
+        if (not params_.options_.noSummary)
+        {
+            ++statistics_.attachmentCount;
+            if (not params_.options_.noAttachmentIndex)
+            {
+                attachment_indices_.emplace_back(attachment, offset);
+            }
+        }
+    }
+
+
+    std::unique_ptr<Chunk> McapWriter::getFreeChunk()
+    {
+        std::unique_ptr<Chunk> chunk;
+        if (free_chunks_.empty())
+        {
+            chunk = std::make_unique<Chunk>();
+            chunk->records_.checksum_enabled_ = not params_.options_.noChunkCRC;
+            chunk->records_.reserve(params_.options_.chunkSize);
+        }
+        else
+        {
+            chunk = std::move(free_chunks_.back());
+            free_chunks_.pop_back();
+        }
+        chunk->message_indices_.resize(channels_.size());
+        return (chunk);
+    }
+
+
+    void McapWriter::closeChunk()
+    {
+        chunk_open_time_ = mcap::MaxTime;
+        ++chunk_sequence_;
+        if (0 != chunk_->fill_start_)
+        {
+            chunk_->fill_duration_ = getSteadyTime() - chunk_->fill_start_;
+        }
+
+        if (pool_.size() > 0)
+        {
+            pool_.push(*chunk_);
+            compressed_chunks_.push_back(std::move(chunk_));
+            chunk_ = getFreeChunk();
+
+            // limit memory consumption if compression does not keep up
+            writeCompressedChunks(compressed_chunks_.size() > 2 * pool_.size());
+        }
+        else
+        {
+            compressor_->compress(*chunk_);
+            if (recording_)
+            {
+                finishChunk(std::move(chunk_));
+                chunk_ = getFreeChunk();
+            }
+            else
+            {
+                writeChunk(*chunk_);
+                chunk_->clear();
+            }
+        }
+    }
+
+
+    void McapWriter::finishChunk(std::unique_ptr<Chunk> chunk)
+    {
+        if (recording_)
+        {
+            ring_bytes_ += chunk->dataSize();
+            ring_.push_back(std::move(chunk));
+
+            // the newest chunk is always retained
+            while (ring_.size() > 1)
+            {
+                const Chunk &oldest = *ring_.front();
+                if ((params_.ring_size_ > 0 and ring_bytes_ > params_.ring_size_)
+                    or (params_.ring_duration_ > 0 and mcap::MaxTime != oldest.start_time_
+                        and ring_.back()->end_time_ - oldest.start_time_ > params_.ring_duration_))
+                {
+                    ring_bytes_ -= oldest.dataSize();
+                    ring_.front()->clear();
+                    free_chunks_.push_back(std::move(ring_.front()));
+                    ring_.pop_front();
+                }
+                else
+                {
+                    break;
+                }
+            }
+        }
+        else
+        {
+            writeChunk(*chunk);
+            chunk->clear();
+            free_chunks_.push_back(std::move(chunk));
+        }
+    }
+
+
+    void McapWriter::writeCompressedChunks(const bool wait_all)
+    {
+        while (not compressed_chunks_.empty())
+        {
+            Chunk &chunk = *compressed_chunks_.front();
+
+            if (wait_all)
+            {
+                pool_.wait(chunk);
+            }
+            else
+            {
+                if (not pool_.ready(chunk))
+                {
+                    break;
+                }
+            }
+
+            finishChunk(std::move(compressed_chunks_.front()));
+            compressed_chunks_.pop_front();
+        }
+    }
+
+
+    void McapWriter::writeChunk(Chunk &chunk)
+    {
+        const mcap::McapWriterOptions &options = params_.options_;
+
+        const std::string compression =
+                chunk.shuffled_ ? str_concat(ChunkShuffler::COMPRESSION_PREFIX,
+                                             mcap::internal::CompressionString(chunk.compression_))
+                                : mcap::internal::CompressionString(chunk.compression_);
+
+        const uint64_t chunk_start_offset = file_.size();
+        mcap::McapWriter::write(
+                file_,
+                mcap::Chunk{ chunk.start_time_,
+                             chunk.end_time_,
+                             chunk.records_.size(),
+                             chunk.records_.checksum(),
+                             compression,
+                             chunk.dataSize(),
+                             chunk.data() });
+        const uint64_t chunk_length = file_.size() - chunk_start_offset;
+
+
+        mcap::ChunkIndex chunk_index;
+        const uint64_t message_index_offset = file_.size();
+        if (not options.noMessageIndex)
+        {
+            for (const mcap::MessageIndex &message_index : chunk.message_indices_)
+            {
+                if (not message_index.records.empty())
+                {
+                    chunk_index.messageIndexOffsets.emplace(message_index.channelId, file_.size());
+                    mcap::McapWriter::write(file_, message_index);
+                }
+            }
+        }
+
+        if (not options.noChunkIndex)
+        {
+            // chunk may contain only schema and channel records
+            chunk_index.messageStartTime = mcap::MaxTime == chunk.start_time_ ? 0 : chunk.start_time_;
+            chunk_index.messageEndTime = chunk.end_time_;
+            chunk_index.chunkStartOffset = chunk_start_offset;
+            chunk_index.chunkLength = chunk_length;
+            chunk_index.messageIndexLength = file_.size() - message_index_offset;
+            chunk_index.compression = compression;
+            chunk_index.compressedSize = chunk.dataSize();
+            chunk_index.uncompressedSize = chunk.records_.size();
+
+            chunk_indices_.push_back(std::move(chunk_index));
+        }
+
+        ++statistics_.chunkCount;
+
+        addChunkStatistics(chunk);
+    }
+
+
+    void McapWriter::addChunkStatistics(Chunk &chunk)
+    {
+        if (0 == chunk.message_count_)
+        {
+            return;
+        }
+
+        if (not params_.options_.noSummary)
+        {
+            if (0 == statistics_.messageCount)
+            {
+                statistics_.messageStartTime = chunk.start_time_;
+                statistics_.messageEndTime = chunk.end_time_;
+            }
+            else
+            {
+                statistics_.messageStartTime = std::min(statistics_.messageStartTime, chunk.start_time_);
+                statistics_.messageEndTime = std::max(statistics_.messageEndTime, chunk.end_time_);
+            }
+            statistics_.messageCount += chunk.message_count_;
+            for (const auto &[channel_id, count] : chunk.channel_message_counts_)
+            {
+                statistics_.channelMessageCounts[channel_id] += count;
+            }
+        }
+
+        chunk.message_count_ = 0;
+        chunk.channel_message_counts_.clear();
+    }
+
+
+    void McapWriter::closeLastChunk()
+    {
+        if (not opened_)
+        {
+            return;
+        }
+
+        if (chunk_ and not chunk_->empty())
+        {
+            closeChunk();
+        }
+        writeCompressedChunks(/*wait_all=*/true);
+    }
+
+
+    void McapWriter::closeExpiredChunk(const uint64_t time)
+    {
+        if (not chunk_ or 0 == params_.max_chunk_latency_)
+        {
+            return;
+        }
+
+        const uint64_t chunk_count = statistics_.chunkCount;
+
+        if (not chunk_->empty())
+        {
+            if (mcap::MaxTime == chunk_open_time_)
+            {
+                chunk_open_time_ = time;
+            }
+            else
+            {
+                if (time > chunk_open_time_ and time - chunk_open_time_ >= params_.max_chunk_latency_)
+                {
+                    closeChunk();
+                }
+            }
+        }
+        writeCompressedChunks(/*wait_all=*/false);
+
+        if (chunk_count != statistics_.chunkCount)
+        {
+            file_.flush();
+        }
+    }
+
+
+    void McapWriter::trigger(const std::function<void()> &prologue)
+    {
+        if (not opened_ or not recording_)
+        {
+            return;
+        }
+
+        writeCompressedChunks(/*wait_all=*/true);
+        recording_ = false;
+
+        // records may be in dropped chunks
+        for (std::size_t i = 0; i < schemas_.size(); ++i)
+        {
+            if (written_schemas_[i])
+            {
+                mcap::McapWriter::write(file_, schemas_[i]);
+            }
+        }
+        for (std::size_t i = 0; i < channels_.size(); ++i)
+        {
+            if (written_channels_[i])
+            {
+                mcap::McapWriter::write(file_, channels_[i]);
+            }
+        }
+
+        std::unique_ptr<Chunk> current_chunk = std::move(chunk_);
+        chunk_ = getFreeChunk();
+        prologue();
+        if (not chunk_->empty())
+        {
+            closeChunk();
+            writeCompressedChunks(/*wait_all=*/true);
+        }
+        free_chunks_.push_back(std::move(chunk_));
+        chunk_ = std::move(current_chunk);
+
+        for (std::unique_ptr<Chunk> &chunk : ring_)
+        {
+            finishChunk(std::move(chunk));
+        }
+        ring_.clear();
+        ring_bytes_ = 0;
+
+        // current chunk is going to be written as usual
+        addChunkStatistics(*chunk_);
+    }
+
+
+    bool McapWriter::isRecording() const
+    {
+        return (recording_);
+    }
+
+
+    void McapWriter::flush()
+    {
+        if (opened_)
+        {
+            closeLastChunk();
+            file_.flush();
+        }
+    }
+}  // namespace pjmsg_mcap_wrapper
@@ -0,0 +1,408 @@
+/**
+    @file
+    @author Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#pragma once
+
+#pragma GCC diagnostic push
+/// @todo presumably GCC bug
+#pragma GCC diagnostic ignored "-Warray-bounds"
+#include <mcap/writer.hpp>
+#pragma GCC diagnostic pop
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "chunk_filter.h"
+
+struct LZ4F_cctx_s;
+
+
+namespace pjmsg_mcap_wrapper
+{
+    /**
+     * Growable in-memory record sink, unlike std::vector does not initialize
+     * memory on growth, so that records can be serialized in place.
+     */
+    class RecordBuffer final : public mcap::IWritable
+    {
+    protected:
+        std::unique_ptr<std::byte[]> data_;  // NOLINT
+        std::size_t size_ = 0;
+        std::size_t capacity_ = 0;
+        uint32_t checksum_;
+
+    public:
+        /// Used instead of mcap::IWritable::crcEnabled, which cannot be
+        /// updated in place.
+        bool checksum_enabled_ = false;
+
+    public:
+        RecordBuffer();
+
+        void end() override;
+        [[nodiscard]] uint64_t size() const override;
+        [[nodiscard]] const std::byte *data() const;
+        [[nodiscard]] bool empty() const;
+
+        void reserve(const std::size_t capacity);
+        void clear();
+
+        /// Returns uninitialized memory, which must be filled and passed to
+        /// updateChecksum().
+        std::byte *append(const std::size_t size);
+        void updateChecksum(const std::byte *data, const std::size_t size);
+        [[nodiscard]] uint32_t checksum() const;
+
+    protected:
+        void handleWrite(const std::byte *data, uint64_t size) override;
+    };
+
+
+    /// Chunk with its message indices, travels between compression threads.
+    class Chunk
+    {
+    public:
+        RecordBuffer records_;
+        std::vector<std::byte> compressed_;
+        /// Indexed by channel id - 1.
+        std::vector<mcap::MessageIndex> message_indices_;
+        mcap::Timestamp start_time_;
+        mcap::Timestamp end_time_;
+        /// Compression that is actually applied to the data.
+        mcap::Compression compression_;
+        /// Records are filtered with ChunkShuffler before compression.
+        bool shuffled_;
+        /// Set when compression is finished, guarded by pool mutex.
+        bool ready_;
+        /// Messages that are not yet accounted in file statistics, see
+        /// McapWriter::Parameters::ring_size_.
+        uint64_t message_count_;
+        std::map<mcap::ChannelId, uint64_t> channel_message_counts_;
+        /// Steady clock time of the first message and time until the chunk
+        /// was closed in nanoseconds, measured only in adaptive compression
+        /// mode.
+        uint64_t fill_start_;
+        uint64_t fill_duration_;
+        /// Streaming compression state: records compressed so far, size of
+        /// the compressed data in compressed_, and time spent on
+        /// compression in adaptive mode.
+        uint64_t stream_input_size_;
+        std::size_t stream_output_size_;
+        uint64_t stream_duration_;
+
+    public:
+        Chunk();
+        void clear();
+        [[nodiscard]] bool empty() const;
+
+        [[nodiscard]] const std::byte *data() const;
+        [[nodiscard]] uint64_t dataSize() const;
+    };
+
+
+    /// Parameters of McapWriter.
+    class McapWriterParameters
+    {
+    public:
+        mcap::McapWriterOptions options_;
+        /// Compress chunks in this many threads, 0 -- compress in the
+        /// writing thread.
+        std::size_t compression_threads_;
+        /// Filter chunk records with ChunkShuffler before compression, such
+        /// chunks get "shuffle+" prefix in compression string.
+        bool shuffle_;
+        /// ZSTD dictionary, stored in the file as an attachment, see
+        /// McapWriter::ZSTD_DICTIONARY_ATTACHMENT; ignored by other
+        /// compression types.
+        std::vector<std::byte> zstd_dictionary_;
+        /// ZSTD only: options_.compressionLevel is the initial level, which
+        /// is adjusted after each chunk, see ChunkCompressor.
+        bool adaptive_compression_;
+        /// ZSTD only: records are compressed as they are committed, see
+        /// ChunkCompressor::feed(), ignored if compression_threads_ > 0.
+        bool streaming_compression_;
+        /// Chunk is closed when its first message is older than this many
+        /// nanoseconds, see McapWriter::closeExpiredChunk(), 0 -- disabled.
+        uint64_t max_chunk_latency_;
+        /**
+         * Flight recorder mode: closed chunks are kept in memory until
+         * McapWriter::trigger() instead of being written, only the most
+         * recent chunks with total size up to ring_size_ bytes and time span
+         * up to ring_duration_ nanoseconds are retained. 0 -- no limit, the
+         * mode is enabled if any of the limits is set.
+         */
+        std::size_t ring_size_;
+        uint64_t ring_duration_;
+
+    public:
+        McapWriterParameters();
+    };
+
+
+    /**
+     * Compresses chunks, in adaptive mode ZSTD level is lowered when
+     * compression of a chunk takes a large fraction of the time it took to
+     * fill the chunk, and raised when it takes a small fraction. In
+     * streaming mode ZSTD frame is built incrementally by feed() and
+     * finalized by compress().
+     */
+    class ChunkCompressor
+    {
+    protected:
+        mcap::Compression compression_;
+        bool force_;
+        bool shuffle_;
+        ZSTD_CCtx_s *zstd_context_;
+        int zstd_level_;
+        LZ4F_cctx_s *lz4_context_;
+        int lz4_level_;
+        ChunkShuffler shuffler_;
+        std::vector<std::byte> shuffled_;
+
+        bool streaming_;
+        /// Chunk whose frame is being built by the ZSTD context.
+        const Chunk *stream_chunk_;
+
+        bool adaptive_;
+        /// Compression time is compared to chunk fill time multiplied by
+        /// this.
+        double fill_time_scale_;
+
+    public:
+        ChunkCompressor(const McapWriterParameters &params);
+        ~ChunkCompressor();
+
+        ChunkCompressor(const ChunkCompressor &) = delete;
+        ChunkCompressor &operator=(const ChunkCompressor &) = delete;
+
+        void compress(Chunk &chunk);
+        /// Compress records added to the chunk since the previous call if
+        /// there are enough of them, does nothing if streaming is disabled.
+        void feed(Chunk &chunk);
+
+    protected:
+        std::size_t compressZstd(Chunk &chunk, const std::byte *input, const std::size_t input_size);
+        std::size_t compressLz4(Chunk &chunk, const std::byte *input, const std::size_t input_size);
+        std::size_t streamZstd(Chunk &chunk, const bool end);
+        void adaptLevel(const uint64_t fill_duration, const uint64_t compression_duration);
+    };
+
+
+    /// Compresses chunks in worker threads, chunks must be collected in
+    /// submission order using wait().
+    class CompressionPool
+    {
+    protected:
+        std::vector<std::thread> threads_;
+        std::deque<Chunk *> pending_;
+        std::mutex mutex_;
+        std::condition_variable pending_condition_;
+        std::condition_variable ready_condition_;
+        bool stop_ = false;
+
+    protected:
+        void run(const McapWriterParameters &params);
+
+    public:
+        ~CompressionPool();
+
+        /// Starts params.compression_threads_ threads, params must remain
+        /// valid until stop().
+        void start(const McapWriterParameters &params);
+        void stop();
+        [[nodiscard]] std::size_t size() const;
+
+        void push(Chunk &chunk);
+        void wait(Chunk &chunk);
+        [[nodiscard]] bool ready(Chunk &chunk);
+    };
+
+
+    /**
+     * MCAP writer which assembles chunks on its own instead of relying on
+     * mcap::McapWriter: the latter compresses chunks in place and does not
+     * allow to delegate compression to other threads. Serialization of
+     * records is still performed by mcap::McapWriter static methods.
+     */
+    class McapWriter
+    {
+    public:
+        /// All fields of the message record except data, see
+        /// mcap::McapWriter::write().
+        static constexpr std::size_t MESSAGE_PREFIX_SIZE = 1 + 8 + 2 + 4 + 8 + 8;
+        /// Name of the attachment containing Parameters::zstd_dictionary_.
+        inline static const char *const ZSTD_DICTIONARY_ATTACHMENT = "pjmsg_mcap_wrapper/zstd_dictionary";
+
+    public:
+        using Parameters = McapWriterParameters;
+
+    protected:
+        Parameters params_;
+
+        mcap::FileWriter file_;
+        bool opened_ = false;
+
+        std::vector<mcap::Schema> schemas_;
+        std::vector<mcap::Channel> channels_;
+        std::vector<bool> written_schemas_;
+        std::vector<bool> written_channels_;
+
+        mcap::Statistics statistics_;
+        std::vector<mcap::ChunkIndex> chunk_indices_;
+        std::vector<mcap::AttachmentIndex> attachment_indices_;
+        std::vector<mcap::MetadataIndex> metadata_indices_;
+
+        std::unique_ptr<Chunk> chunk_;
+        /// Time of the first closeExpiredChunk() call after current chunk
+        /// received messages.
+        uint64_t chunk_open_time_ = mcap::MaxTime;
+        /// Incremented when a chunk is closed.
+        uint64_t chunk_sequence_ = 0;
+        /// Chunks submitted for compression, in file order.
+        std::deque<std::unique_ptr<Chunk>> compressed_chunks_;
+        std::vector<std::unique_ptr<Chunk>> free_chunks_;
+        /// Recorded chunks in flight recorder mode.
+        std::deque<std::unique_ptr<Chunk>> ring_;
+        uint64_t ring_bytes_ = 0;
+        bool recording_ = false;
+        std::unique_ptr<ChunkCompressor> compressor_;
+        CompressionPool pool_;
+
+        /// Serialization buffer for unchunked output.
+        RecordBuffer scratch_;
+
+    protected:
+        mcap::IWritable &getOutput();
+
+        uint64_t beginMessages(const mcap::Message &message, const std::size_t count, const uint64_t *log_times);
+        std::byte *reserveMessages(
+                const mcap::Message &message,
+                const uint64_t record_size,
+                std::size_t &count,
+                const uint64_t *log_times);
+        static void writeMessagePrefix(
+                std::byte *record,
+                const mcap::Message &message,
+                const mcap::Timestamp log_time,
+                const mcap::Timestamp publish_time);
+        void commitMessages(const std::byte *records, const std::size_t size);
+
+        std::unique_ptr<Chunk> getFreeChunk();
+        void closeChunk();
+        void finishChunk(std::unique_ptr<Chunk> chunk);
+        void writeChunk(Chunk &chunk);
+        void addChunkStatistics(Chunk &chunk);
+        void writeCompressedChunks(const bool wait_all);
+        void updateStatistics(const mcap::Message &message, const std::size_t count, const uint64_t *log_times);
+
+    public:
+        ~McapWriter();
+
+        void open(const std::string_view &filename, const Parameters &params);
+        void close();
+
+        void addSchema(mcap::Schema &schema);
+        void addChannel(mcap::Channel &channel);
+        /// Copy schemas and channels preserving their ids, must be called
+        /// before open().
+        void copyDefinitions(const McapWriter &other);
+
+        /// Bytes written to the file excluding buffered chunks.
+        [[nodiscard]] uint64_t fileSize() const;
+        /// Sequence number of the chunk that is going to receive the
+        /// message, always the same for unchunked output.
+        [[nodiscard]] uint64_t getChunkSequence(const mcap::Message &message) const;
+
+        void write(const mcap::Message &message);
+        /// Metadata is written outside of chunks.
+        void write(const mcap::Metadata &metadata);
+        /// Attachments are written outside of chunks, CRC is computed here.
+        void write(mcap::Attachment &attachment);
+
+        /**
+         * Write message with payload of message.dataSize bytes generated by
+         * serializer(std::byte *) directly in the chunk buffer, message.data
+         * is ignored.
+         */
+        template <class t_Serializer>
+        void write(const mcap::Message &message, t_Serializer &&serializer)
+        {
+            write(message, 1, [&serializer](const std::size_t /*index*/, std::byte *payload) { serializer(payload); });
+        }
+
+        /**
+         * Write count messages sharing channel, timestamps and payload size,
+         * payload of i-th message is generated by serializer(i, std::byte *).
+         * If log_times is given, i-th message gets log_times[i] as log and
+         * publish time instead of message timestamps. Bookkeeping and chunk
+         * overflow checks are performed once per group of messages that fit
+         * in the current chunk.
+         */
+        template <class t_Serializer>
+        void write(
+                const mcap::Message &message,
+                const std::size_t count,
+                t_Serializer &&serializer,
+                const uint64_t *log_times = nullptr)
+        {
+            const uint64_t record_size = beginMessages(message, count, log_times);
+
+            for (std::size_t index = 0; index < count;)
+            {
+                std::size_t group_size = count - index;
+                std::byte *const records = reserveMessages(
+                        message,
+                        record_size,
+                        group_size,
+                        nullptr == log_times ? nullptr : log_times + index);  // NOLINT
+
+                std::byte *record = records;
+                for (const std::size_t group_end = index + group_size; index < group_end; ++index)
+                {
+                    if (nullptr == log_times)
+                    {
+                        writeMessagePrefix(record, message, message.logTime, message.publishTime);
+                    }
+                    else
+                    {
+                        writeMessagePrefix(record, message, log_times[index], log_times[index]);
+                    }
+                    serializer(index, record + MESSAGE_PREFIX_SIZE);  // NOLINT
+                    record += record_size;                            // NOLINT
+                }
+
+                commitMessages(records, group_size * record_size);
+            }
+        }
+
+        /// Write current chunk and wait for all chunks that are being
+        /// compressed.
+        void closeLastChunk();
+        /**
+         * Close and write current chunk if it has been holding messages for
+         * max_chunk_latency_, flush written chunks to the file. Time is
+         * measured with an arbitrary monotonic clock provided by the caller,
+         * the check is intended to be performed periodically.
+         */
+        void closeExpiredChunk(const uint64_t time);
+        /**
+         * Stop recording in flight recorder mode: write recorded chunks,
+         * subsequent messages are written directly. Messages written by
+         * prologue() are placed in a separate chunk before recorded chunks.
+         */
+        void trigger(const std::function<void()> &prologue);
+        [[nodiscard]] bool isRecording() const;
+        /// Write current chunk (keep it in flight recorder mode) and flush
+        /// the file.
+        void flush();
+    };
+}  // namespace pjmsg_mcap_wrapper
@@ -94,6 +94,47 @@ MSG: builtin_interfaces/Time
 # The seconds component, valid over all int32 values.
 int32 sec
 
+# The nanoseconds component, valid in the range [0, 10e9).
+uint32 nanosec
+)SCHEMA";
+        };
+
+
+        template <>
+        class Message<plotjuggler_msgs::msg::StatisticsValuesFloat32>
+        {
+        public:
+            inline static const char *const type = "plotjuggler_msgs/msg/StatisticsValuesFloat32";  // NOLINT
+
+            inline static const char *const schema =  // NOLINT
+                    R"SCHEMA(
+# header
+std_msgs/Header header
+
+# Statistics
+float32[] values
+uint32 names_version # The values vector corresponds to the name vector with the same name
+
+================================================================================
+MSG: std_msgs/Header
+# Standard metadata for higher-level stamped data types.
+# This is generally used to communicate timestamped data
+# in a particular coordinate frame.
+
+# Two-integer timestamp that is expressed as seconds and nanoseconds.
+builtin_interfaces/Time stamp
+
+# Transform frame with which this data is associated.
+string frame_id
+
+================================================================================
+MSG: builtin_interfaces/Time
+# This message communicates ROS Time defined here:
+# https://design.ros2.org/articles/clock_and_time.html
+
+# The seconds component, valid over all int32 values.
+int32 sec
+
 # The nanoseconds component, valid in the range [0, 10e9).
 uint32 nanosec
 )SCHEMA";
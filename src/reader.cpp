@@ -0,0 +1,1376 @@
+/**
+    @file
+    @author Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#include "pjmsg_mcap_wrapper/reader.h"
+#include "pjmsg_mcap_wrapper/chunk_decoder.h"
+#include "pjmsg_mcap_wrapper/sparse_decoder.h"
+#include "pjmsg_mcap_wrapper/xor_decoder.h"
+#include "pjmsg_mcap_wrapper/zstd_dictionary.h"
+#include "3rdparty.h"
+#include "util.h"
+#include "message_impl.h"
+#include "plotjuggler_msgs.h"
+#include "sparse_codec.h"
+#include "xor_codec.h"
+#include "values_parser.h"
+#include "channel_type.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <mcap/reader.hpp>
+
+#include "mcap_records.h"
+
+
+namespace
+{
+    /// Decoded chunks that are waiting to be merged, per thread.
+    constexpr std::size_t CHUNKS_PER_THREAD = 2;
+    /// Messages decoded in the calling thread are merged in batches.
+    constexpr std::size_t MERGE_BATCH_SIZE = 1024;
+    /// Granularity of the time index of recordings without chunk index.
+    constexpr uint64_t INDEX_BLOCK_SIZE = 1 << 20;
+}  // namespace
+
+
+namespace pjmsg_mcap_wrapper
+{
+    namespace
+    {
+        /// Positions and columns of selected signals in messages of a names
+        /// version.
+        class Layout
+        {
+        public:
+            std::size_t size_ = 0;
+            std::vector<int64_t> positions_;
+            std::vector<std::size_t> columns_;
+        };
+        using LayoutPtr = std::shared_ptr<const Layout>;
+
+
+        /// Columns of a topic prefix.
+        class Stream
+        {
+        public:
+            Reader::Series series_;
+            std::string topic_prefix_;
+
+        protected:
+            /// Only the requested signals are read.
+            bool selective_ = false;
+            std::vector<bool> found_;
+
+            std::unordered_map<std::string, std::size_t> name_columns_;
+            std::unordered_map<uint32_t, LayoutPtr> layouts_;
+
+            /// Layouts of selected signals available to decoding threads.
+            std::mutex mutex_;
+            std::unordered_map<uint32_t, LayoutPtr> published_layouts_;
+
+        protected:
+            const Layout &getLayout(const uint32_t names_version, const std::size_t count) const
+            {
+                const auto iterator = layouts_.find(names_version);
+                SHARF_THROW_IF(
+                        layouts_.end() == iterator,
+                        "Names version ",
+                        std::to_string(names_version),
+                        " of '",
+                        topic_prefix_,
+                        "' is not found");
+                SHARF_THROW_IF(
+                        iterator->second->size_ != count,
+                        "Number of values does not match number of names in '",
+                        topic_prefix_,
+                        "'");
+                return (*iterator->second);
+            }
+
+            void push(const std::size_t column, const std::size_t row, const double value)
+            {
+                std::vector<double> &values = series_.values_[column];
+                values.resize(row, std::numeric_limits<double>::quiet_NaN());
+                values.push_back(value);
+            }
+
+        public:
+            void select(const std::vector<std::string> &signals)
+            {
+                selective_ = true;
+                found_.assign(signals.size(), false);
+                series_.names_ = signals;
+                series_.values_.resize(signals.size());
+
+                for (std::size_t i = 0; i < signals.size(); ++i)
+                {
+                    SHARF_THROW_IF(
+                            not name_columns_.emplace(signals[i], i).second, "Signal '", signals[i], "' is repeated");
+                }
+            }
+
+            [[nodiscard]] bool isSelective() const
+            {
+                return (selective_);
+            }
+
+            /// Layout for decoding threads or nullptr if it is not known yet.
+            LayoutPtr getPublishedLayout(const uint32_t names_version)
+            {
+                const std::lock_guard<std::mutex> lock(mutex_);
+                const auto iterator = published_layouts_.find(names_version);
+                return (published_layouts_.end() == iterator ? nullptr : iterator->second);
+            }
+
+            void addNames(const uint32_t names_version, const std::string *names, const std::size_t count)
+            {
+                const std::shared_ptr<Layout> layout = std::make_shared<Layout>();
+                layout->size_ = count;
+
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    std::size_t column;
+                    if (selective_)
+                    {
+                        const auto iterator = name_columns_.find(names[i]);  // NOLINT
+                        if (name_columns_.end() == iterator)
+                        {
+                            continue;
+                        }
+                        column = iterator->second;
+                        found_[column] = true;
+                    }
+                    else
+                    {
+                        const auto [iterator, inserted] =
+                                name_columns_.emplace(names[i], series_.names_.size());  // NOLINT
+                        if (inserted)
+                        {
+                            series_.names_.push_back(names[i]);  // NOLINT
+                            series_.values_.emplace_back();
+                        }
+                        column = iterator->second;
+                    }
+                    layout->positions_.push_back(static_cast<int64_t>(i));
+                    layout->columns_.push_back(column);
+                }
+
+                layouts_[names_version] = layout;
+                if (selective_)
+                {
+                    const std::lock_guard<std::mutex> lock(mutex_);
+                    published_layouts_[names_version] = layout;
+                }
+            }
+
+            /// All values of a message, missing values are filled lazily.
+            void addValues(
+                    const uint64_t timestamp,
+                    const uint32_t names_version,
+                    const double *values,
+                    const std::size_t count)
+            {
+                const Layout &layout = getLayout(names_version, count);
+                const std::size_t row = series_.timestamps_.size();
+
+                for (std::size_t i = 0; i < layout.positions_.size(); ++i)
+                {
+                    push(layout.columns_[i], row, values[layout.positions_[i]]);  // NOLINT
+                }
+                series_.timestamps_.push_back(timestamp);
+            }
+
+            /// Values gathered according to the layout.
+            void addValues(const uint64_t timestamp, const Layout &layout, const double *values)
+            {
+                const std::size_t row = series_.timestamps_.size();
+
+                for (std::size_t i = 0; i < layout.columns_.size(); ++i)
+                {
+                    push(layout.columns_[i], row, values[i]);  // NOLINT
+                }
+                series_.timestamps_.push_back(timestamp);
+            }
+
+            /// Selected signals may be missing if only a part of the
+            /// recording is read.
+            void finalize(const bool complete)
+            {
+                for (std::size_t i = 0; complete and i < found_.size(); ++i)
+                {
+                    SHARF_THROW_IF(
+                            not found_[i], "Signal '", series_.names_[i], "' is not found in '", topic_prefix_, "'");
+                }
+
+                for (std::vector<double> &column : series_.values_)
+                {
+                    column.resize(series_.timestamps_.size(), std::numeric_limits<double>::quiet_NaN());
+                }
+            }
+        };
+
+
+        class Channel
+        {
+        public:
+            ChannelType type_;
+            Stream *stream_;
+        };
+
+        /// Channels of the requested streams, read-only while decoding.
+        using Channels = std::unordered_map<uint16_t, Channel>;
+
+
+        /// Decoded messages in file order, travels between decoding threads.
+        class DecodedChunk
+        {
+        public:
+            class Record
+            {
+            public:
+                Stream *stream_;
+                uint64_t timestamp_;
+                uint32_t names_version_;
+                /// Offset in values_ or names_.
+                std::size_t offset_;
+                std::size_t count_;
+                bool names_;
+                /// Values are gathered according to this layout, which is
+                /// kept alive by the decoding thread, nullptr -- all values.
+                const Layout *layout_;
+            };
+
+        public:
+            const mcap::ChunkIndex *index_ = nullptr;
+            /// Values logged outside of [start_time_, end_time_) are skipped,
+            /// names are always decoded.
+            uint64_t start_time_ = 0;
+            uint64_t end_time_ = std::numeric_limits<uint64_t>::max();
+
+            std::vector<Record> records_;
+            std::vector<double> values_;
+            std::vector<std::string> names_;
+            std::exception_ptr error_;
+            /// Set when decoding is finished, guarded by pool mutex.
+            bool ready_ = false;
+
+        public:
+            void clear()
+            {
+                records_.clear();
+                values_.clear();
+                names_.clear();
+                error_ = nullptr;
+            }
+
+            /// Replay decoded messages in order.
+            void merge()
+            {
+                for (const Record &record : records_)
+                {
+                    if (record.names_)
+                    {
+                        record.stream_->addNames(
+                                record.names_version_,
+                                names_.data() + record.offset_,  // NOLINT
+                                record.count_);
+                    }
+                    else if (nullptr == record.layout_)
+                    {
+                        record.stream_->addValues(
+                                record.timestamp_,
+                                record.names_version_,
+                                values_.data() + record.offset_,  // NOLINT
+                                record.count_);
+                    }
+                    else
+                    {
+                        record.stream_->addValues(
+                                record.timestamp_,
+                                *record.layout_,
+                                values_.data() + record.offset_);  // NOLINT
+                    }
+                }
+                clear();
+            }
+        };
+
+
+        /// Decoding state of a thread.
+        class ChunkReader
+        {
+        protected:
+            mcap_records::FilePtr file_ = mcap_records::FilePtr(nullptr, &std::fclose);
+            std::unique_ptr<mcap::FileReader> input_;
+            ChunkDecoder chunk_decoder_;
+
+            /// Decoders of XOR and sparse channels.
+            std::unordered_map<uint16_t, std::unique_ptr<XorDecoder>> xor_decoders_;
+            std::unordered_map<uint16_t, std::unique_ptr<SparseDecoder>> sparse_decoders_;
+
+            plotjuggler_msgs::msg::StatisticsNames names_;
+            ValuesView<double> values_;
+            ValuesView<float> float32_values_;
+            Message message_;
+
+            /// Layouts of selected signals used by this thread.
+            std::unordered_map<const Stream *, std::unordered_map<uint32_t, LayoutPtr>> layouts_;
+
+        protected:
+            template <class t_Message>
+            static void deserialize(const std::byte *data, const std::size_t size, t_Message &message)
+            {
+                // FastCDR does not modify the buffer when reading
+                eprosima::fastcdr::FastBuffer buffer(
+                        const_cast<char *>(reinterpret_cast<const char *>(data)), size);  // NOLINT
+                eprosima::fastcdr::Cdr cdr(
+                        buffer, eprosima::fastcdr::Cdr::DEFAULT_ENDIAN, eprosima::fastcdr::CdrVersion::XCDRv1);
+                cdr.read_encapsulation();
+                cdr >> message;
+            }
+
+            template <class t_Message>
+            static uint64_t getStamp(const t_Message &message)
+            {
+                return (static_cast<uint64_t>(message.header().stamp().sec()) * std::nano::den
+                        + message.header().stamp().nanosec());
+            }
+
+            /// Returns nullptr until the first keyframe of the channel, e.g.,
+            /// when decoding starts in the middle of a recording.
+            template <class t_Decoder>
+            static t_Decoder *getDecoder(
+                    std::unordered_map<uint16_t, std::unique_ptr<t_Decoder>> &decoders,
+                    const mcap::Message &message)
+            {
+                std::unique_ptr<t_Decoder> &decoder = decoders[message.channelId];
+                if (not decoder)
+                {
+                    if (not t_Decoder::isKeyframe(message.data, message.dataSize))
+                    {
+                        return (nullptr);
+                    }
+                    decoder = std::make_unique<t_Decoder>();
+                }
+                return (decoder.get());
+            }
+
+            const Layout *getLayout(Stream &stream, const uint32_t names_version)
+            {
+                LayoutPtr &layout = layouts_[&stream][names_version];
+                if (not layout)
+                {
+                    layout = stream.getPublishedLayout(names_version);
+                }
+                return (layout.get());
+            }
+
+            /**
+             * Only selected values are copied if their layout is known,
+             * otherwise all values are copied and selected while merging,
+             * e.g., when names are in a chunk that is not merged yet.
+             */
+            template <class t_Value>
+            void addValues(
+                    DecodedChunk &chunk,
+                    const Channel &channel,
+                    const uint64_t timestamp,
+                    const uint32_t names_version,
+                    const std::byte *values,
+                    const std::size_t count)
+            {
+                const Layout *layout = channel.stream_->isSelective() ? getLayout(*channel.stream_, names_version)
+                                                                      : nullptr;
+                const std::size_t offset = chunk.values_.size();
+
+                if (nullptr != layout and layout->size_ == count)
+                {
+                    chunk.values_.resize(offset + layout->positions_.size());
+                    gatherValues<t_Value>(values, layout->positions_, &chunk.values_[offset]);
+                }
+                else
+                {
+                    layout = nullptr;
+                    chunk.values_.resize(offset + count);
+                    copyValues<t_Value>(values, count, &chunk.values_[offset]);
+                }
+
+                chunk.records_.push_back(DecodedChunk::Record{
+                        channel.stream_, timestamp, names_version, offset, count, false, layout });
+            }
+
+        public:
+            void setZstdDictionary(const std::vector<std::byte> &dictionary)
+            {
+                chunk_decoder_.setZstdDictionary(dictionary);
+            }
+
+            ChunkDecoder &getChunkDecoder()
+            {
+                return (chunk_decoder_);
+            }
+
+            void open(const std::filesystem::path &filename)
+            {
+                file_ = mcap_records::openFile(filename);
+                input_ = std::make_unique<mcap::FileReader>(file_.get());
+            }
+
+            /// Forget previous XOR and sparse messages, e.g., when skipping
+            /// to another chunk.
+            void resetDecoders()
+            {
+                xor_decoders_.clear();
+                sparse_decoders_.clear();
+            }
+
+            void decode(const Channels &channels, const mcap::Message &message, DecodedChunk &chunk)
+            {
+                const auto iterator = channels.find(message.channelId);
+                if (channels.end() == iterator)
+                {
+                    return;
+                }
+                const Channel &channel = iterator->second;
+
+                if (ChannelType::NAMES != channel.type_ and message.logTime >= chunk.end_time_)
+                {
+                    return;
+                }
+                const bool skip = message.logTime < chunk.start_time_;
+
+                switch (channel.type_)
+                {
+                    case ChannelType::NAMES:
+                        deserialize(message.data, message.dataSize, names_);
+                        chunk.records_.push_back(DecodedChunk::Record{
+                                channel.stream_,
+                                getStamp(names_),
+                                names_.names_version(),
+                                chunk.names_.size(),
+                                names_.names().size(),
+                                true,
+                                nullptr });
+                        chunk.names_.insert(chunk.names_.end(), names_.names().begin(), names_.names().end());
+                        break;
+
+                    case ChannelType::VALUES:
+                        if (skip)
+                        {
+                            break;
+                        }
+                        values_.parse(message.data, message.dataSize);
+                        addValues<double>(
+                                chunk,
+                                channel,
+                                values_.stamp_,
+                                values_.names_version_,
+                                values_.values_,
+                                values_.count_);
+                        break;
+
+                    case ChannelType::VALUES_FLOAT32:
+                        if (skip)
+                        {
+                            break;
+                        }
+                        float32_values_.parse(message.data, message.dataSize);
+                        addValues<float>(
+                                chunk,
+                                channel,
+                                float32_values_.stamp_,
+                                float32_values_.names_version_,
+                                float32_values_.values_,
+                                float32_values_.count_);
+                        break;
+
+                    case ChannelType::VALUES_XOR:
+                    case ChannelType::VALUES_SPARSE:
+                    default:
+                        // skipped messages are still needed to decode
+                        // subsequent ones
+                        if (ChannelType::VALUES_XOR == channel.type_)
+                        {
+                            XorDecoder *decoder = getDecoder(xor_decoders_, message);
+                            if (nullptr == decoder)
+                            {
+                                break;
+                            }
+                            decoder->decode(message.data, message.dataSize, message_);
+                        }
+                        else
+                        {
+                            SparseDecoder *decoder = getDecoder(sparse_decoders_, message);
+                            if (nullptr == decoder)
+                            {
+                                break;
+                            }
+                            decoder->decode(message.data, message.dataSize, message_);
+                        }
+                        if (skip)
+                        {
+                            break;
+                        }
+                        addValues<double>(
+                                chunk,
+                                channel,
+                                message_.getStamp(),
+                                message_.pimpl_->values_.names_version(),
+                                reinterpret_cast<const std::byte *>(message_.values().data()),  // NOLINT
+                                message_.values().size());
+                        break;
+                }
+            }
+
+            /// Decode messages of the chunk given by chunk.index_, the file
+            /// must be opened.
+            void decode(const Channels &channels, DecodedChunk &chunk)
+            {
+                const mcap::ChunkIndex &index = *chunk.index_;
+
+                mcap::RecordReader reader(*input_, index.chunkStartOffset, index.chunkStartOffset + index.chunkLength);
+                const std::optional<mcap::Record> record = reader.next();
+                SHARF_THROW_IF(
+                        not record or mcap::OpCode::Chunk != record->opcode,
+                        "Failed to read chunk at ",
+                        std::to_string(index.chunkStartOffset));
+
+                mcap::Chunk mcap_chunk;
+                mcap::Status status = mcap::McapReader::ParseChunk(*record, &mcap_chunk);
+                SHARF_THROW_IF(not status.ok(), "Failed to parse chunk: ", status.message);
+
+                // each chunk starts with a keyframe
+                resetDecoders();
+
+                mcap_records::visitChunkRecords(
+                        chunk_decoder_.decode(
+                                mcap_chunk.compression,
+                                mcap_chunk.records,
+                                mcap_chunk.compressedSize,
+                                mcap_chunk.uncompressedSize),
+                        [&](const mcap::OpCode opcode, const std::byte *data, const uint64_t size)
+                        {
+                            if (mcap::OpCode::Message == opcode)
+                            {
+                                const mcap::Record message_record{
+                                    opcode, size, const_cast<std::byte *>(data)  // NOLINT
+                                };
+                                mcap::Message message;
+                                status = mcap::McapReader::ParseMessage(message_record, &message);
+                                SHARF_THROW_IF(not status.ok(), "Failed to parse message: ", status.message);
+
+                                decode(channels, message, chunk);
+                            }
+                            return (true);
+                        });
+            }
+        };
+
+
+        /// Decodes chunks in worker threads, chunks must be collected in
+        /// submission order using wait().
+        class DecodingPool
+        {
+        protected:
+            std::vector<std::thread> threads_;
+            std::deque<DecodedChunk *> pending_;
+            std::mutex mutex_;
+            std::condition_variable pending_condition_;
+            std::condition_variable ready_condition_;
+            bool stop_ = false;
+
+        protected:
+            void run(const std::filesystem::path &filename,
+                     const std::vector<std::byte> &dictionary,
+                     const Channels &channels)
+            {
+                ChunkReader reader;
+                std::exception_ptr error;
+                try
+                {
+                    reader.open(filename);
+                    reader.setZstdDictionary(dictionary);
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+
+                for (;;)
+                {
+                    DecodedChunk *chunk = nullptr;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex_);
+                        pending_condition_.wait(lock, [this] { return (stop_ or not pending_.empty()); });
+                        if (pending_.empty())
+                        {
+                            return;
+                        }
+                        chunk = pending_.front();
+                        pending_.pop_front();
+                    }
+
+                    chunk->error_ = error;
+                    if (not error)
+                    {
+                        try
+                        {
+                            reader.decode(channels, *chunk);
+                        }
+                        catch (...)
+                        {
+                            chunk->error_ = std::current_exception();
+                        }
+                    }
+
+                    {
+                        const std::lock_guard<std::mutex> lock(mutex_);
+                        chunk->ready_ = true;
+                    }
+                    ready_condition_.notify_all();
+                }
+            }
+
+        public:
+            ~DecodingPool()
+            {
+                stop();
+            }
+
+            /// Arguments must remain valid until stop().
+            void start(
+                    const std::size_t threads,
+                    const std::filesystem::path &filename,
+                    const std::vector<std::byte> &dictionary,
+                    const Channels &channels)
+            {
+                stop();
+
+                stop_ = false;
+                threads_.reserve(threads);
+                for (std::size_t i = 0; i < threads; ++i)
+                {
+                    threads_.emplace_back(
+                            &DecodingPool::run, this, std::cref(filename), std::cref(dictionary), std::cref(channels));
+                }
+            }
+
+            void stop()
+            {
+                {
+                    const std::lock_guard<std::mutex> lock(mutex_);
+                    stop_ = true;
+                    pending_.clear();
+                }
+                pending_condition_.notify_all();
+
+                for (std::thread &thread : threads_)
+                {
+                    thread.join();
+                }
+                threads_.clear();
+            }
+
+            void push(DecodedChunk &chunk)
+            {
+                {
+                    const std::lock_guard<std::mutex> lock(mutex_);
+                    chunk.ready_ = false;
+                    pending_.push_back(&chunk);
+                }
+                pending_condition_.notify_one();
+            }
+
+            /// Rethrows decoding errors.
+            void wait(DecodedChunk &chunk)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    ready_condition_.wait(lock, [&chunk] { return (chunk.ready_); });
+                }
+                if (chunk.error_)
+                {
+                    std::rethrow_exception(chunk.error_);
+                }
+            }
+        };
+
+
+        /**
+         * Part of a recording without chunk index: a run of top level
+         * records or a chunk.
+         */
+        class IndexBlock
+        {
+        public:
+            /// [begin_, end_) file offsets.
+            uint64_t begin_ = 0;
+            uint64_t end_ = 0;
+            /// Log time bounds of messages.
+            uint64_t min_time_ = std::numeric_limits<uint64_t>::max();
+            uint64_t max_time_ = 0;
+            /// XOR and sparse messages of the block can be decoded starting
+            /// from this offset, i.e., from the preceding keyframes.
+            uint64_t resume_offset_ = 0;
+            /// Contains names messages.
+            bool names_ = false;
+            /// Contains schemas or channels, which are always needed.
+            bool definitions_ = false;
+        };
+    }  // namespace
+
+
+    class Reader::Implementation
+    {
+    protected:
+        using Region = std::pair<uint64_t, uint64_t>;
+
+    protected:
+        std::filesystem::path filename_;
+        std::size_t threads_ = 1;
+        std::vector<std::byte> dictionary_;
+
+        /// Summary of chunked recordings.
+        bool summary_read_ = false;
+        std::vector<mcap::ChunkIndex> chunk_indexes_;
+        /// Latest message end time of chunk_indexes_[0..i].
+        std::vector<mcap::Timestamp> chunk_end_times_;
+        /// chunk_indexes_ in file order.
+        std::vector<const mcap::ChunkIndex *> file_chunks_;
+        std::unordered_map<uint16_t, mcap::ChannelPtr> summary_channels_;
+        std::unordered_map<uint16_t, mcap::SchemaPtr> summary_schemas_;
+
+        /// Time index of recordings without chunk index, built by the first
+        /// range query.
+        bool indexed_ = false;
+        std::vector<IndexBlock> index_blocks_;
+
+        std::unordered_map<uint16_t, std::string> schemas_;
+        Channels channels_;
+        std::map<std::string, Stream> streams_;
+        /// Signals to read, empty -- all.
+        std::vector<std::string> signals_;
+        /// Log time range of values to read.
+        uint64_t start_time_ = 0;
+        uint64_t end_time_ = std::numeric_limits<uint64_t>::max();
+
+    protected:
+        /// Only channels of the given topic prefix are added unless it is
+        /// empty.
+        void addChannel(const mcap::Channel &channel, const std::string &topic_prefix)
+        {
+            const auto schema = schemas_.find(channel.schemaId);
+            ChannelType type;
+            if (schemas_.end() == schema or not getChannelType(schema->second, type))
+            {
+                return;
+            }
+
+            // '<topic_prefix>/names', '<topic_prefix>/values', ...
+            const std::string prefix = channel.topic.substr(0, channel.topic.rfind('/'));
+            if (not topic_prefix.empty() and topic_prefix != prefix)
+            {
+                return;
+            }
+
+            const auto [stream, inserted] = streams_.try_emplace(prefix);
+            if (inserted)
+            {
+                stream->second.topic_prefix_ = prefix;
+                if (not signals_.empty())
+                {
+                    stream->second.select(signals_);
+                }
+            }
+            channels_[channel.id] = Channel{ type, &stream->second };
+        }
+
+        /// Chunk indexes are sorted by start time.
+        void readSummary()
+        {
+            summary_read_ = true;
+
+            const mcap_records::FilePtr file = mcap_records::openFile(filename_);
+            mcap::FileReader input(file.get());
+            mcap::McapReader reader;
+
+            if (reader.open(input).ok() and reader.readSummary(mcap::ReadSummaryMethod::NoFallbackScan).ok())
+            {
+                chunk_indexes_ = reader.chunkIndexes();
+                summary_channels_ = reader.channels();
+                summary_schemas_ = reader.schemas();
+
+                std::sort(
+                        chunk_indexes_.begin(),
+                        chunk_indexes_.end(),
+                        [](const mcap::ChunkIndex &left, const mcap::ChunkIndex &right)
+                        {
+                            return (std::tie(left.messageStartTime, left.chunkStartOffset)
+                                    < std::tie(right.messageStartTime, right.chunkStartOffset));
+                        });
+
+                chunk_end_times_.resize(chunk_indexes_.size());
+                mcap::Timestamp end_time = 0;
+                for (std::size_t i = 0; i < chunk_indexes_.size(); ++i)
+                {
+                    end_time = std::max(end_time, chunk_indexes_[i].messageEndTime);
+                    chunk_end_times_[i] = end_time;
+                }
+
+                file_chunks_.clear();
+                for (const mcap::ChunkIndex &index : chunk_indexes_)
+                {
+                    file_chunks_.push_back(&index);
+                }
+                std::sort(file_chunks_.begin(), file_chunks_.end(), compareOffsets);
+            }
+            reader.close();
+        }
+
+        /// Order of chunks in the file.
+        static bool compareOffsets(const mcap::ChunkIndex *left, const mcap::ChunkIndex *right)
+        {
+            return (left->chunkStartOffset < right->chunkStartOffset);
+        }
+
+        /// Names channels of the stream, of all streams if topic_prefix is
+        /// empty.
+        [[nodiscard]] std::unordered_set<uint16_t> getNamesChannels(const std::string &topic_prefix) const
+        {
+            std::unordered_set<uint16_t> names_channels;
+            for (const std::pair<const uint16_t, mcap::ChannelPtr> &channel : summary_channels_)
+            {
+                const auto schema = summary_schemas_.find(channel.second->schemaId);
+                ChannelType type;
+                if (summary_schemas_.end() == schema or not getChannelType(schema->second->name, type)
+                    or ChannelType::NAMES != type)
+                {
+                    continue;
+                }
+
+                const std::string &topic = channel.second->topic;
+                if (topic_prefix.empty() or topic.substr(0, topic.rfind('/')) == topic_prefix)
+                {
+                    names_channels.insert(channel.first);
+                }
+            }
+            return (names_channels);
+        }
+
+        /**
+         * Chunks overlapping the time range in file order, names chunks
+         * between them, and, for each names channel, the last chunk that
+         * contains it before them. Chunks without message index may contain
+         * any channel, so all such chunks are selected until names are
+         * found in indexed chunks.
+         */
+        [[nodiscard]] std::vector<const mcap::ChunkIndex *> selectChunks(const std::string &topic_prefix) const
+        {
+            const auto compare = [](const mcap::ChunkIndex &index, const uint64_t time)
+            {
+                return (index.messageStartTime < time);
+            };
+
+            // time bounds of chunks are inclusive: chunks starting in the
+            // range overlap it, preceding chunks may overlap it
+            const std::vector<mcap::ChunkIndex>::const_iterator end =
+                    std::lower_bound(chunk_indexes_.begin(), chunk_indexes_.end(), end_time_, compare);
+            const std::vector<mcap::ChunkIndex>::const_iterator first =
+                    std::lower_bound(chunk_indexes_.begin(), end, start_time_, compare);
+
+            std::vector<const mcap::ChunkIndex *> indexes;
+            for (std::size_t i = static_cast<std::size_t>(first - chunk_indexes_.begin());
+                 i > 0 and chunk_end_times_[i - 1] >= start_time_;
+                 --i)
+            {
+                if (chunk_indexes_[i - 1].messageEndTime >= start_time_)
+                {
+                    indexes.push_back(&chunk_indexes_[i - 1]);
+                }
+            }
+            for (std::vector<mcap::ChunkIndex>::const_iterator index = first; index != end; ++index)
+            {
+                indexes.push_back(&*index);
+            }
+            std::sort(indexes.begin(), indexes.end(), compareOffsets);
+
+            // with non-monotonic timestamps names may be updated between
+            // selected chunks in file order
+            uint64_t first_offset = std::numeric_limits<uint64_t>::max();
+            std::vector<const mcap::ChunkIndex *>::const_iterator last = file_chunks_.end();
+            if (not indexes.empty())
+            {
+                first_offset = indexes.front()->chunkStartOffset;
+                last = std::upper_bound(file_chunks_.begin(), file_chunks_.end(), indexes.back(), compareOffsets);
+            }
+
+            const std::size_t selected_count = indexes.size();
+            std::unordered_set<uint16_t> names_channels = getNamesChannels(topic_prefix);
+            for (std::vector<const mcap::ChunkIndex *>::const_iterator iterator = last;
+                 iterator != file_chunks_.begin() and not names_channels.empty();)
+            {
+                --iterator;
+
+                const mcap::ChunkIndex &index = **iterator;
+                const bool preceding = index.chunkStartOffset < first_offset;
+                bool selected = index.messageIndexOffsets.empty();
+                for (const std::pair<const uint16_t, mcap::ByteOffset> &offset : index.messageIndexOffsets)
+                {
+                    if (preceding ? names_channels.erase(offset.first) > 0 : names_channels.count(offset.first) > 0)
+                    {
+                        selected = true;
+                    }
+                }
+
+                if (selected)
+                {
+                    indexes.push_back(&index);
+                }
+            }
+
+            if (indexes.size() > selected_count)
+            {
+                std::sort(indexes.begin(), indexes.end(), compareOffsets);
+                indexes.erase(std::unique(indexes.begin(), indexes.end()), indexes.end());
+            }
+            return (indexes);
+        }
+
+        /**
+         * Scan top level records: messages are grouped in blocks of about
+         * INDEX_BLOCK_SIZE bytes, chunks form separate blocks and are
+         * not decompressed.
+         */
+        void buildIndex()
+        {
+            index_blocks_.clear();
+
+            const mcap_records::FilePtr file = mcap_records::openFile(filename_);
+            mcap::FileReader input(file.get());
+            mcap::RecordReader reader(input, sizeof(mcap::Magic));
+
+            std::unordered_map<uint16_t, std::string> schemas;
+            std::unordered_map<uint16_t, ChannelType> channels;
+            /// Offsets of last keyframes of XOR and sparse channels.
+            std::unordered_map<uint16_t, uint64_t> keyframes;
+            /// XOR and sparse channels of the current block.
+            std::unordered_set<uint16_t> block_channels;
+            bool chunk_block = false;
+
+            for (std::optional<mcap::Record> record = reader.next(); record; record = reader.next())
+            {
+                if (mcap::OpCode::DataEnd == record->opcode or mcap::OpCode::Footer == record->opcode)
+                {
+                    break;
+                }
+
+                const uint64_t offset = reader.curRecordOffset();
+                const bool chunk = mcap::OpCode::Chunk == record->opcode;
+                if (index_blocks_.empty() or chunk or chunk_block
+                    or offset - index_blocks_.back().begin_ >= INDEX_BLOCK_SIZE)
+                {
+                    index_blocks_.emplace_back();
+                    index_blocks_.back().begin_ = offset;
+                    index_blocks_.back().resume_offset_ = offset;
+                    block_channels.clear();
+                }
+                chunk_block = chunk;
+
+                IndexBlock &block = index_blocks_.back();
+                block.end_ = reader.offset;
+
+                switch (record->opcode)
+                {
+                    case mcap::OpCode::Schema:
+                    {
+                        mcap::Schema schema;
+                        const mcap::Status status = mcap::McapReader::ParseSchema(*record, &schema);
+                        SHARF_THROW_IF(not status.ok(), "Failed to parse schema: ", status.message);
+                        schemas[schema.id] = schema.name;
+                        block.definitions_ = true;
+                        break;
+                    }
+
+                    case mcap::OpCode::Channel:
+                    {
+                        mcap::Channel channel;
+                        const mcap::Status status = mcap::McapReader::ParseChannel(*record, &channel);
+                        SHARF_THROW_IF(not status.ok(), "Failed to parse channel: ", status.message);
+
+                        const auto schema = schemas.find(channel.schemaId);
+                        ChannelType type;
+                        if (schemas.end() != schema and getChannelType(schema->second, type))
+                        {
+                            channels[channel.id] = type;
+                        }
+                        block.definitions_ = true;
+                        break;
+                    }
+
+                    case mcap::OpCode::Chunk:
+                    {
+                        mcap::Chunk mcap_chunk;
+                        const mcap::Status status = mcap::McapReader::ParseChunk(*record, &mcap_chunk);
+                        SHARF_THROW_IF(not status.ok(), "Failed to parse chunk: ", status.message);
+
+                        // contents are unknown without decompression
+                        block.min_time_ = mcap_chunk.messageStartTime;
+                        block.max_time_ = mcap_chunk.messageEndTime;
+                        block.definitions_ = true;
+                        break;
+                    }
+
+                    case mcap::OpCode::Message:
+                    {
+                        mcap::Message message;
+                        const mcap::Status status = mcap::McapReader::ParseMessage(*record, &message);
+                        SHARF_THROW_IF(not status.ok(), "Failed to parse message: ", status.message);
+
+                        block.min_time_ = std::min(block.min_time_, message.logTime);
+                        block.max_time_ = std::max(block.max_time_, message.logTime);
+
+                        const auto channel = channels.find(message.channelId);
+                        if (channels.end() == channel)
+                        {
+                            break;
+                        }
+
+                        if (ChannelType::NAMES == channel->second)
+                        {
+                            block.names_ = true;
+                        }
+                        else if (ChannelType::VALUES_XOR == channel->second
+                                 or ChannelType::VALUES_SPARSE == channel->second)
+                        {
+                            const bool keyframe = (ChannelType::VALUES_XOR == channel->second)
+                                                          ? XorDecoder::isKeyframe(message.data, message.dataSize)
+                                                          : SparseDecoder::isKeyframe(message.data, message.dataSize);
+
+                            if (block_channels.insert(message.channelId).second and not keyframe)
+                            {
+                                const auto last_keyframe = keyframes.find(message.channelId);
+                                if (keyframes.end() != last_keyframe)
+                                {
+                                    block.resume_offset_ = std::min(block.resume_offset_, last_keyframe->second);
+                                }
+                            }
+                            if (keyframe)
+                            {
+                                keyframes[message.channelId] = offset;
+                            }
+                        }
+                        break;
+                    }
+
+                    default:
+                        break;
+                }
+            }
+
+            SHARF_THROW_IF(
+                    not reader.status().ok(), "Failed to read ", filename_.native(), ": ", reader.status().message);
+            indexed_ = true;
+        }
+
+        /// File regions of blocks overlapping the time range and preceding
+        /// blocks with names or definitions.
+        std::vector<Region> selectRegions()
+        {
+            if (not indexed_)
+            {
+                buildIndex();
+            }
+
+            std::vector<Region> regions;
+            for (const IndexBlock &block : index_blocks_)
+            {
+                if (block.min_time_ < end_time_ and block.max_time_ >= start_time_)
+                {
+                    regions.emplace_back(block.resume_offset_, block.end_);
+                }
+                else if (block.definitions_ or (block.names_ and block.min_time_ < end_time_))
+                {
+                    regions.emplace_back(block.begin_, block.end_);
+                }
+            }
+
+            // messages must not be decoded twice
+            std::sort(regions.begin(), regions.end());
+            std::vector<Region> merged;
+            for (const Region &region : regions)
+            {
+                if (not merged.empty() and region.first <= merged.back().second)
+                {
+                    merged.back().second = std::max(merged.back().second, region.second);
+                }
+                else
+                {
+                    merged.push_back(region);
+                }
+            }
+            return (merged);
+        }
+
+        /// Recordings without chunk index are decoded in the calling thread,
+        /// regions must point to top level records.
+        void readSequential(const std::string &topic_prefix, const std::vector<Region> &regions)
+        {
+            ChunkReader reader;
+            reader.setZstdDictionary(dictionary_);
+            DecodedChunk chunk;
+            chunk.start_time_ = start_time_;
+            chunk.end_time_ = end_time_;
+
+            const auto visitor = [&](const mcap::OpCode opcode, const std::byte *data, const uint64_t size)
+            {
+                const mcap::Record record{ opcode, size, const_cast<std::byte *>(data) };  // NOLINT
+
+                switch (opcode)
+                {
+                    case mcap::OpCode::Schema:
+                    {
+                        mcap::Schema schema;
+                        const mcap::Status status = mcap::McapReader::ParseSchema(record, &schema);
+                        SHARF_THROW_IF(not status.ok(), "Failed to parse schema: ", status.message);
+                        schemas_[schema.id] = schema.name;
+                        break;
+                    }
+
+                    case mcap::OpCode::Channel:
+                    {
+                        mcap::Channel channel;
+                        const mcap::Status status = mcap::McapReader::ParseChannel(record, &channel);
+                        SHARF_THROW_IF(not status.ok(), "Failed to parse channel: ", status.message);
+                        addChannel(channel, topic_prefix);
+                        break;
+                    }
+
+                    case mcap::OpCode::Message:
+                    {
+                        mcap::Message message;
+                        const mcap::Status status = mcap::McapReader::ParseMessage(record, &message);
+                        SHARF_THROW_IF(not status.ok(), "Failed to parse message: ", status.message);
+
+                        reader.decode(channels_, message, chunk);
+                        if (chunk.records_.size() >= MERGE_BATCH_SIZE)
+                        {
+                            chunk.merge();
+                        }
+                        break;
+                    }
+
+                    default:
+                        break;
+                }
+                return (true);
+            };
+
+            for (const Region &region : regions)
+            {
+                reader.resetDecoders();
+                mcap_records::visitRecords(filename_, reader.getChunkDecoder(), visitor, region.first, region.second);
+            }
+
+            chunk.merge();
+        }
+
+        /// Chunks are decoded in parallel and merged in the given order, which
+        /// must be the file order: names precede dependent values and
+        /// timestamps follow the order of sequential reading.
+        void readParallel(const std::string &topic_prefix, const std::vector<const mcap::ChunkIndex *> &indexes)
+        {
+            for (const std::pair<const uint16_t, mcap::SchemaPtr> &schema : summary_schemas_)
+            {
+                schemas_[schema.first] = schema.second->name;
+            }
+            for (const std::pair<const uint16_t, mcap::ChannelPtr> &channel : summary_channels_)
+            {
+                addChannel(*channel.second, topic_prefix);
+            }
+            if (channels_.empty() or indexes.empty())
+            {
+                return;
+            }
+
+            std::vector<DecodedChunk> chunks(std::min(CHUNKS_PER_THREAD * threads_, indexes.size()));
+            for (DecodedChunk &chunk : chunks)
+            {
+                chunk.start_time_ = start_time_;
+                chunk.end_time_ = end_time_;
+            }
+
+            DecodingPool pool;
+            pool.start(threads_, filename_, dictionary_, channels_);
+
+            std::size_t submitted = 0;
+            for (; submitted < chunks.size(); ++submitted)
+            {
+                chunks[submitted].index_ = indexes[submitted];
+                pool.push(chunks[submitted]);
+            }
+
+            for (std::size_t merged = 0; merged < indexes.size(); ++merged)
+            {
+                DecodedChunk &chunk = chunks[merged % chunks.size()];
+
+                pool.wait(chunk);
+                chunk.merge();
+
+                if (submitted < indexes.size())
+                {
+                    chunk.index_ = indexes[submitted];
+                    pool.push(chunk);
+                    ++submitted;
+                }
+            }
+        }
+
+    public:
+        void open(const std::filesystem::path &filename, const Reader::Parameters &params)
+        {
+            filename_.clear();
+            threads_ = (0 == params.threads_) ? std::max(1U, std::thread::hardware_concurrency()) : params.threads_;
+            dictionary_ = ZstdDictionary::read(filename);
+
+            summary_read_ = false;
+            chunk_indexes_.clear();
+            chunk_end_times_.clear();
+            file_chunks_.clear();
+            summary_channels_.clear();
+            summary_schemas_.clear();
+            indexed_ = false;
+            index_blocks_.clear();
+
+            filename_ = filename;
+            if (threads_ > 1)
+            {
+                readSummary();
+            }
+        }
+
+        /// Values logged in [start_time, end_time) are read.
+        std::map<std::string, Reader::Series> read(
+                const std::string &topic_prefix,
+                const std::vector<std::string> &signals = std::vector<std::string>(),
+                const uint64_t start_time = 0,
+                const uint64_t end_time = std::numeric_limits<uint64_t>::max())
+        {
+            SHARF_THROW_IF(filename_.empty(), "Reader is not opened");
+
+            schemas_.clear();
+            channels_.clear();
+            streams_.clear();
+            signals_ = signals;
+            start_time_ = start_time;
+            end_time_ = end_time;
+
+            const bool full = 0 == start_time and std::numeric_limits<uint64_t>::max() == end_time;
+            if (not full and not summary_read_)
+            {
+                readSummary();
+            }
+
+            if (chunk_indexes_.empty())
+            {
+                readSequential(
+                        topic_prefix,
+                        full ? std::vector<Region>{ Region(sizeof(mcap::Magic), mcap::EndOffset) } : selectRegions());
+            }
+            else if (full and threads_ <= 1)
+            {
+                readSequential(topic_prefix, { Region(sizeof(mcap::Magic), mcap::EndOffset) });
+            }
+            else if (full)
+            {
+                readParallel(topic_prefix, file_chunks_);
+            }
+            else
+            {
+                readParallel(topic_prefix, selectChunks(topic_prefix));
+            }
+
+            std::map<std::string, Reader::Series> result;
+            for (std::pair<const std::string, Stream> &stream : streams_)
+            {
+                stream.second.finalize(full);
+                result.emplace(stream.first, std::move(stream.second.series_));
+            }
+
+            channels_.clear();
+            streams_.clear();
+
+            return (result);
+        }
+    };
+}  // namespace pjmsg_mcap_wrapper
+
+
+namespace pjmsg_mcap_wrapper
+{
+    Reader::Reader() : pimpl_(std::make_unique<Reader::Implementation>())
+    {
+    }
+
+    Reader::~Reader() = default;
+
+    void Reader::open(const std::filesystem::path &filename, const Parameters &params)
+    {
+        pimpl_->open(filename, params);
+    }
+
+    std::map<std::string, Reader::Series> Reader::read()
+    {
+        return (pimpl_->read(""));
+    }
+
+    Reader::Series Reader::read(const std::string &topic_prefix)
+    {
+        SHARF_THROW_IF(topic_prefix.empty(), "Topic prefix must not be empty");
+
+        std::map<std::string, Series> streams = pimpl_->read(topic_prefix);
+        const auto iterator = streams.find(topic_prefix);
+        SHARF_THROW_IF(streams.end() == iterator, "Stream '", topic_prefix, "' is not found");
+
+        return (std::move(iterator->second));
+    }
+
+    Reader::Series Reader::read(const std::string &topic_prefix, const std::vector<std::string> &signals)
+    {
+        SHARF_THROW_IF(topic_prefix.empty(), "Topic prefix must not be empty");
+        SHARF_THROW_IF(signals.empty(), "No signals are given");
+
+        std::map<std::string, Series> streams = pimpl_->read(topic_prefix, signals);
+        const auto iterator = streams.find(topic_prefix);
+        SHARF_THROW_IF(streams.end() == iterator, "Stream '", topic_prefix, "' is not found");
+
+        return (std::move(iterator->second));
+    }
+
+    Reader::Series Reader::range(
+            const std::string &topic_prefix,
+            const uint64_t start_time,
+            const uint64_t end_time,
+            const std::vector<std::string> &signals)
+    {
+        SHARF_THROW_IF(topic_prefix.empty(), "Topic prefix must not be empty");
+        SHARF_THROW_IF(start_time >= end_time, "Time range is empty");
+
+        std::map<std::string, Series> streams = pimpl_->read(topic_prefix, signals, start_time, end_time);
+        const auto iterator = streams.find(topic_prefix);
+        SHARF_THROW_IF(streams.end() == iterator, "Stream '", topic_prefix, "' is not found");
+
+        return (std::move(iterator->second));
+    }
+}  // namespace pjmsg_mcap_wrapper
@@ -0,0 +1,461 @@
+/**
+    @file
+    @author Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#include "pjmsg_mcap_wrapper/replayer.h"
+#include "pjmsg_mcap_wrapper/chunk_decoder.h"
+#include "pjmsg_mcap_wrapper/sparse_decoder.h"
+#include "pjmsg_mcap_wrapper/xor_decoder.h"
+#include "pjmsg_mcap_wrapper/zstd_dictionary.h"
+#include "3rdparty.h"
+#include "util.h"
+#include "message_impl.h"
+#include "plotjuggler_msgs.h"
+#include "sparse_codec.h"
+#include "xor_codec.h"
+#include "values_parser.h"
+#include "channel_type.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <mcap/reader.hpp>
+
+#include "mcap_records.h"
+
+
+namespace pjmsg_mcap_wrapper
+{
+    namespace
+    {
+        /// Read-only memory mapping of a file.
+        class MappedFile
+        {
+        protected:
+            const std::byte *data_ = nullptr;
+            std::size_t size_ = 0;
+
+        public:
+            ~MappedFile()
+            {
+                close();
+            }
+
+            void open(const std::filesystem::path &filename)
+            {
+                close();
+
+                const int descriptor = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);  // NOLINT
+                SHARF_THROW_IF(descriptor < 0, "Failed to open ", filename.native(), ": ", std::strerror(errno));
+
+                struct stat status;
+                if (0 != ::fstat(descriptor, &status))
+                {
+                    const int error = errno;
+                    ::close(descriptor);
+                    SHARF_THROW_IF(true, "Failed to stat ", filename.native(), ": ", std::strerror(error));
+                }
+
+                const std::size_t size = static_cast<std::size_t>(status.st_size);
+                void *data = (size > 0) ? ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0) : MAP_FAILED;
+                const int error = errno;
+                // mapping remains valid after the descriptor is closed
+                ::close(descriptor);
+                SHARF_THROW_IF(
+                        MAP_FAILED == data,  // NOLINT
+                        "Failed to map ",
+                        filename.native(),
+                        ": ",
+                        (size > 0) ? std::strerror(error) : "file is empty");
+
+                ::madvise(data, size, MADV_SEQUENTIAL);
+
+                data_ = static_cast<const std::byte *>(data);
+                size_ = size;
+            }
+
+            void close()
+            {
+                if (nullptr != data_)
+                {
+                    ::munmap(const_cast<std::byte *>(data_), size_);  // NOLINT
+                    data_ = nullptr;
+                    size_ = 0;
+                }
+            }
+
+            [[nodiscard]] const std::byte *data() const
+            {
+                return (data_);
+            }
+
+            [[nodiscard]] std::size_t size() const
+            {
+                return (size_);
+            }
+        };
+
+
+        /// Position in a sequence of records, which are parsed in place.
+        class RecordCursor
+        {
+        protected:
+            const std::byte *data_ = nullptr;
+            std::size_t size_ = 0;
+            std::size_t offset_ = 0;
+
+        public:
+            void reset(const std::byte *data = nullptr, const std::size_t size = 0)
+            {
+                data_ = data;
+                size_ = size;
+                offset_ = 0;
+            }
+
+            /// Returns false at the end of the sequence.
+            bool next(mcap::Record &record)
+            {
+                if (offset_ + mcap_records::RECORD_HEADER_SIZE > size_)
+                {
+                    return (false);
+                }
+
+                uint64_t length;
+                std::memcpy(&length, data_ + offset_ + 1, sizeof(length));  // NOLINT
+                SHARF_THROW_IF(
+                        length > size_ - offset_ - mcap_records::RECORD_HEADER_SIZE,
+                        "Malformed record at ",
+                        std::to_string(offset_));
+
+                record.opcode = static_cast<mcap::OpCode>(data_[offset_]);                                  // NOLINT
+                record.dataSize = length;
+                record.data = const_cast<std::byte *>(data_ + offset_ + mcap_records::RECORD_HEADER_SIZE);  // NOLINT
+
+                offset_ += mcap_records::RECORD_HEADER_SIZE + length;
+                return (true);
+            }
+        };
+
+
+        class Stream
+        {
+        public:
+            std::string topic_prefix_;
+            std::unordered_map<uint32_t, std::vector<std::string>> names_;
+        };
+
+
+        class Channel
+        {
+        public:
+            ChannelType type_;
+            Stream *stream_;
+        };
+    }  // namespace
+
+
+    class Replayer::Implementation
+    {
+    protected:
+        MappedFile file_;
+        /// Top level records.
+        RecordCursor records_;
+        /// Records of the current chunk.
+        RecordCursor chunk_records_;
+        ChunkDecoder chunk_decoder_;
+        bool finished_ = false;
+
+        std::unordered_map<uint16_t, std::string> schemas_;
+        std::unordered_map<uint16_t, Channel> channels_;
+        std::map<std::string, Stream> streams_;
+
+        std::unordered_map<uint16_t, std::unique_ptr<XorDecoder>> xor_decoders_;
+        std::unordered_map<uint16_t, std::unique_ptr<SparseDecoder>> sparse_decoders_;
+
+        plotjuggler_msgs::msg::StatisticsNames names_;
+        ValuesView<double> values_;
+        ValuesView<float> float32_values_;
+        Message message_;
+        /// Converted or realigned values.
+        std::vector<double> buffer_;
+
+        mcap::Message mcap_message_;
+        mcap::Chunk mcap_chunk_;
+
+    protected:
+        template <class t_Decoder>
+        static t_Decoder &getDecoder(
+                std::unordered_map<uint16_t, std::unique_ptr<t_Decoder>> &decoders,
+                const uint16_t channel_id)
+        {
+            std::unique_ptr<t_Decoder> &decoder = decoders[channel_id];
+            if (not decoder)
+            {
+                decoder = std::make_unique<t_Decoder>();
+            }
+            return (*decoder);
+        }
+
+        void addSchema(const mcap::Record &record)
+        {
+            mcap::Schema schema;
+            const mcap::Status status = mcap::McapReader::ParseSchema(record, &schema);
+            SHARF_THROW_IF(not status.ok(), "Failed to parse schema: ", status.message);
+            schemas_[schema.id] = schema.name;
+        }
+
+        void addChannel(const mcap::Record &record)
+        {
+            mcap::Channel channel;
+            const mcap::Status status = mcap::McapReader::ParseChannel(record, &channel);
+            SHARF_THROW_IF(not status.ok(), "Failed to parse channel: ", status.message);
+
+            const auto schema = schemas_.find(channel.schemaId);
+            ChannelType type;
+            if (schemas_.end() == schema or not getChannelType(schema->second, type))
+            {
+                return;
+            }
+
+            // '<topic_prefix>/names', '<topic_prefix>/values', ...
+            const std::string prefix = channel.topic.substr(0, channel.topic.rfind('/'));
+            const auto [stream, inserted] = streams_.try_emplace(prefix);
+            if (inserted)
+            {
+                stream->second.topic_prefix_ = prefix;
+            }
+            channels_[channel.id] = Channel{ type, &stream->second };
+        }
+
+        void startChunk(const mcap::Record &record)
+        {
+            const mcap::Status status = mcap::McapReader::ParseChunk(record, &mcap_chunk_);
+            SHARF_THROW_IF(not status.ok(), "Failed to parse chunk: ", status.message);
+
+            if (mcap_chunk_.compression.empty())
+            {
+                chunk_records_.reset(mcap_chunk_.records, mcap_chunk_.compressedSize);
+            }
+            else
+            {
+                const std::vector<std::byte> &records = chunk_decoder_.decode(
+                        mcap_chunk_.compression,
+                        mcap_chunk_.records,
+                        mcap_chunk_.compressedSize,
+                        mcap_chunk_.uncompressedSize);
+                chunk_records_.reset(records.data(), records.size());
+            }
+
+            // each chunk starts with a keyframe
+            for (std::pair<const uint16_t, std::unique_ptr<XorDecoder>> &decoder : xor_decoders_)
+            {
+                decoder.second->reset();
+            }
+            for (std::pair<const uint16_t, std::unique_ptr<SparseDecoder>> &decoder : sparse_decoders_)
+            {
+                decoder.second->reset();
+            }
+        }
+
+        void addNames(Stream &stream)
+        {
+            // FastCDR does not modify the buffer when reading
+            eprosima::fastcdr::FastBuffer buffer(
+                    const_cast<char *>(reinterpret_cast<const char *>(mcap_message_.data)),  // NOLINT
+                    mcap_message_.dataSize);
+            eprosima::fastcdr::Cdr cdr(
+                    buffer, eprosima::fastcdr::Cdr::DEFAULT_ENDIAN, eprosima::fastcdr::CdrVersion::XCDRv1);
+            cdr.read_encapsulation();
+            cdr >> names_;
+
+            stream.names_[names_.names_version()] = names_.names();
+        }
+
+        /// Values are referenced if they are aligned doubles.
+        template <class t_Value>
+        void setValues(Sample &sample, const ValuesView<t_Value> &values)
+        {
+            sample.timestamp_ = values.stamp_;
+            sample.names_version_ = values.names_version_;
+            sample.size_ = values.count_;
+
+            if (std::is_same_v<t_Value, double>
+                and 0 == reinterpret_cast<std::uintptr_t>(values.values_) % alignof(double))  // NOLINT
+            {
+                sample.values_ = reinterpret_cast<const double *>(values.values_);  // NOLINT
+            }
+            else
+            {
+                // grows to the largest message and is reused afterwards
+                buffer_.resize(values.count_);
+                copyValues<t_Value>(values.values_, values.count_, buffer_.data());
+                sample.values_ = buffer_.data();
+            }
+        }
+
+        void setValues(Sample &sample, const Channel &channel)
+        {
+            switch (channel.type_)
+            {
+                case ChannelType::VALUES:
+                    values_.parse(mcap_message_.data, mcap_message_.dataSize);
+                    setValues(sample, values_);
+                    break;
+
+                case ChannelType::VALUES_FLOAT32:
+                    float32_values_.parse(mcap_message_.data, mcap_message_.dataSize);
+                    setValues(sample, float32_values_);
+                    break;
+
+                case ChannelType::VALUES_XOR:
+                case ChannelType::VALUES_SPARSE:
+                default:
+                    if (ChannelType::VALUES_XOR == channel.type_)
+                    {
+                        getDecoder(xor_decoders_, mcap_message_.channelId)
+                                .decode(mcap_message_.data, mcap_message_.dataSize, message_);
+                    }
+                    else
+                    {
+                        getDecoder(sparse_decoders_, mcap_message_.channelId)
+                                .decode(mcap_message_.data, mcap_message_.dataSize, message_);
+                    }
+                    sample.timestamp_ = message_.getStamp();
+                    sample.names_version_ = message_.pimpl_->values_.names_version();
+                    sample.values_ = message_.values().data();
+                    sample.size_ = message_.values().size();
+                    break;
+            }
+
+            const auto names = channel.stream_->names_.find(sample.names_version_);
+            sample.topic_prefix_ = &channel.stream_->topic_prefix_;
+            sample.names_ = (channel.stream_->names_.end() == names) ? nullptr : &names->second;
+        }
+
+        /// Records of the current chunk are returned first.
+        bool nextRecord(mcap::Record &record)
+        {
+            return (chunk_records_.next(record) or records_.next(record));
+        }
+
+    public:
+        void open(const std::filesystem::path &filename)
+        {
+            file_.open(filename);
+            SHARF_THROW_IF(
+                    file_.size() < sizeof(mcap::Magic) or 0 != std::memcmp(file_.data(), mcap::Magic, sizeof(mcap::Magic)),
+                    filename.native(),
+                    " is not an MCAP file");
+
+            chunk_decoder_.setZstdDictionary(ZstdDictionary::read(filename));
+            rewind();
+        }
+
+        void rewind()
+        {
+            SHARF_THROW_IF(nullptr == file_.data(), "Replayer is not opened");
+
+            records_.reset(file_.data() + sizeof(mcap::Magic), file_.size() - sizeof(mcap::Magic));  // NOLINT
+            chunk_records_.reset();
+            finished_ = false;
+
+            schemas_.clear();
+            channels_.clear();
+            streams_.clear();
+            xor_decoders_.clear();
+            sparse_decoders_.clear();
+        }
+
+        bool next(Sample &sample)
+        {
+            SHARF_THROW_IF(nullptr == file_.data(), "Replayer is not opened");
+
+            mcap::Record record;
+            while (not finished_ and nextRecord(record))
+            {
+                switch (record.opcode)
+                {
+                    case mcap::OpCode::DataEnd:
+                    case mcap::OpCode::Footer:
+                        finished_ = true;
+                        break;
+
+                    case mcap::OpCode::Schema:
+                        addSchema(record);
+                        break;
+
+                    case mcap::OpCode::Channel:
+                        addChannel(record);
+                        break;
+
+                    case mcap::OpCode::Chunk:
+                        startChunk(record);
+                        break;
+
+                    case mcap::OpCode::Message:
+                    {
+                        const mcap::Status status = mcap::McapReader::ParseMessage(record, &mcap_message_);
+                        SHARF_THROW_IF(not status.ok(), "Failed to parse message: ", status.message);
+
+                        const auto channel = channels_.find(mcap_message_.channelId);
+                        if (channels_.end() == channel)
+                        {
+                            break;
+                        }
+
+                        if (ChannelType::NAMES == channel->second.type_)
+                        {
+                            addNames(*channel->second.stream_);
+                            break;
+                        }
+
+                        setValues(sample, channel->second);
+                        return (true);
+                    }
+
+                    default:
+                        break;
+                }
+            }
+
+            finished_ = true;
+            return (false);
+        }
+    };
+}  // namespace pjmsg_mcap_wrapper
+
+
+namespace pjmsg_mcap_wrapper
+{
+    Replayer::Replayer() : pimpl_(std::make_unique<Replayer::Implementation>())
+    {
+    }
+
+    Replayer::~Replayer() = default;
+
+    void Replayer::open(const std::filesystem::path &filename)
+    {
+        pimpl_->open(filename);
+    }
+
+    void Replayer::rewind()
+    {
+        pimpl_->rewind();
+    }
+
+    bool Replayer::next(Sample &sample)
+    {
+        return (pimpl_->next(sample));
+    }
+}  // namespace pjmsg_mcap_wrapper
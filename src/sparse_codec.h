@@ -0,0 +1,159 @@
+/**
+    @file
+    @author Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#pragma once
+
+#include "xor_codec.h"
+
+namespace pjmsg_mcap_wrapper
+{
+    /**
+     * Change-only encoding of StatisticsValues: only values that differ
+     * bitwise from the previous message of the same channel are stored.
+     *
+     * Message layout (host byte order):
+     * flags (uint8) | sec (int32) | nanosec (uint32) | names_version (uint32)
+     * | values count (uint32) | frame_id length (uint32) | frame_id |
+     * changed count (uint32) | positions | values.
+     *
+     * Keyframes contain all values and no positions. Otherwise positions of
+     * changed values are given either as uint32 indices or, if the BITMAP
+     * flag is set, as a bitmap packed LSB first in 64 bit words, whichever is
+     * smaller.
+     */
+    namespace sparse_codec
+    {
+        using xor_codec::copy;
+
+        inline const char *const MESSAGE_ENCODING = "pjmsg_sparse";
+        inline const char *const SCHEMA_NAME = "pjmsg_mcap_wrapper/SparseStatisticsValues";
+        inline const char *const SCHEMA = "Sparse encoded plotjuggler_msgs/msg/StatisticsValues, see "
+                                          "pjmsg_mcap_wrapper::SparseDecoder";
+
+        constexpr uint8_t KEYFRAME = 0x01;
+        constexpr uint8_t BITMAP = 0x02;
+        constexpr std::size_t HEADER_SIZE = xor_codec::HEADER_SIZE;
+
+
+        inline std::size_t getBitmapSize(const std::size_t count)
+        {
+            return ((count + 63) / 64 * sizeof(uint64_t));
+        }
+
+
+        /// Encoder state of a channel.
+        class Encoder
+        {
+        protected:
+            std::vector<uint64_t> previous_;
+            std::vector<uint32_t> changed_;
+            std::vector<uint64_t> bitmap_;
+            std::size_t since_keyframe_ = 0;
+
+            std::vector<std::byte> buffer_;
+
+        public:
+            /// Keyframe is written at least every this many messages.
+            std::size_t keyframe_interval_ = 100;
+
+        public:
+            /// Next message is going to be a keyframe.
+            void reset()
+            {
+                previous_.clear();
+            }
+
+            [[nodiscard]] bool needsKeyframe(const std::size_t count) const
+            {
+                return (previous_.size() != count or previous_.empty() or since_keyframe_ >= keyframe_interval_);
+            }
+
+            const std::vector<std::byte> &encode(
+                    const std::string &frame_id,
+                    const int32_t sec,
+                    const uint32_t nanosec,
+                    const double *values,
+                    const uint32_t count,
+                    const uint32_t names_version,
+                    const bool keyframe)
+            {
+                changed_.clear();
+                if (keyframe)
+                {
+                    previous_.resize(count);
+                    std::memcpy(previous_.data(), values, count * sizeof(double));
+                    since_keyframe_ = 0;
+                }
+                else
+                {
+                    ++since_keyframe_;
+
+                    for (uint32_t i = 0; i < count; ++i)
+                    {
+                        uint64_t value;
+                        std::memcpy(&value, &values[i], sizeof(value));  // NOLINT
+
+                        if (value != previous_[i])
+                        {
+                            previous_[i] = value;
+                            changed_.push_back(i);
+                        }
+                    }
+                }
+
+                const bool bitmap = changed_.size() * sizeof(uint32_t) > getBitmapSize(count);
+                const uint32_t changed_count = keyframe ? count : static_cast<uint32_t>(changed_.size());
+                const std::size_t positions_size =
+                        keyframe ? 0 : (bitmap ? getBitmapSize(count) : changed_.size() * sizeof(uint32_t));
+
+                buffer_.resize(
+                        HEADER_SIZE + frame_id.size() + sizeof(uint32_t) + positions_size
+                        + changed_count * sizeof(double));
+
+                std::byte *data = buffer_.data();
+                data = copy(data, static_cast<uint8_t>((keyframe ? KEYFRAME : 0) | (bitmap ? BITMAP : 0)));
+                data = copy(data, sec);
+                data = copy(data, nanosec);
+                data = copy(data, names_version);
+                data = copy(data, count);
+                data = copy(data, static_cast<uint32_t>(frame_id.size()));
+                std::memcpy(data, frame_id.data(), frame_id.size());
+                data += frame_id.size();  // NOLINT
+                data = copy(data, changed_count);
+
+                if (keyframe)
+                {
+                    std::memcpy(data, previous_.data(), count * sizeof(uint64_t));
+                    return (buffer_);
+                }
+
+                if (bitmap)
+                {
+                    bitmap_.assign(getBitmapSize(count) / sizeof(uint64_t), 0);
+                    for (const uint32_t index : changed_)
+                    {
+                        bitmap_[index / 64] |= uint64_t{ 1 } << (index % 64);
+                    }
+                    std::memcpy(data, bitmap_.data(), positions_size);
+                }
+                else
+                {
+                    std::memcpy(data, changed_.data(), positions_size);
+                }
+                data += positions_size;  // NOLINT
+
+                for (const uint32_t index : changed_)
+                {
+                    data = copy(data, previous_[index]);
+                }
+
+                return (buffer_);
+            }
+        };
+    }  // namespace sparse_codec
+}  // namespace pjmsg_mcap_wrapper
@@ -0,0 +1,148 @@
+/**
+    @file
+    @author Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#include "pjmsg_mcap_wrapper/sparse_decoder.h"
+#include "3rdparty.h"
+#include "util.h"
+#include "message_impl.h"
+#include "sparse_codec.h"
+
+
+namespace pjmsg_mcap_wrapper
+{
+    class SparseDecoder::Implementation
+    {
+    public:
+        std::vector<double> previous_;
+
+    public:
+        void decode(const std::byte *data, const std::size_t size, Message::Implementation &message)
+        {
+            SHARF_THROW_IF(
+                    size < sparse_codec::HEADER_SIZE + sizeof(uint32_t), "Sparse encoded message is truncated");
+
+            const std::byte *const end = data + size;  // NOLINT
+
+            uint8_t flags;
+            int32_t sec;
+            uint32_t nanosec;
+            uint32_t names_version;
+            uint32_t count;
+            uint32_t frame_id_size;
+            uint32_t changed_count;
+
+            data = sparse_codec::copy(flags, data);
+            data = sparse_codec::copy(sec, data);
+            data = sparse_codec::copy(nanosec, data);
+            data = sparse_codec::copy(names_version, data);
+            data = sparse_codec::copy(count, data);
+            data = sparse_codec::copy(frame_id_size, data);
+
+            SHARF_THROW_IF(
+                    frame_id_size + sizeof(uint32_t) > static_cast<std::size_t>(end - data),
+                    "Sparse encoded message is truncated");
+            message.values_.header().frame_id().assign(reinterpret_cast<const char *>(data), frame_id_size);  // NOLINT
+            data += frame_id_size;                                                                              // NOLINT
+            data = sparse_codec::copy(changed_count, data);
+
+            message.values_.header().stamp().sec(sec);
+            message.values_.header().stamp().nanosec(nanosec);
+            message.names_.header().stamp().sec(sec);
+            message.names_.header().stamp().nanosec(nanosec);
+            message.setVersion(names_version);
+
+            const std::size_t available = static_cast<std::size_t>(end - data);
+            SHARF_THROW_IF(changed_count > count, "Invalid sparse encoded message");
+
+            if (0 != (flags & sparse_codec::KEYFRAME))
+            {
+                SHARF_THROW_IF(
+                        changed_count != count or available < count * sizeof(double),
+                        "Sparse encoded keyframe is truncated");
+
+                previous_.resize(count);
+                std::memcpy(previous_.data(), data, count * sizeof(double));
+            }
+            else
+            {
+                SHARF_THROW_IF(previous_.empty() and count > 0, "Sparse encoded message without preceding keyframe");
+                SHARF_THROW_IF(previous_.size() != count, "Sparse encoded message size does not match keyframe");
+
+                const bool bitmap = 0 != (flags & sparse_codec::BITMAP);
+                const std::size_t positions_size =
+                        bitmap ? sparse_codec::getBitmapSize(count) : changed_count * sizeof(uint32_t);
+                SHARF_THROW_IF(
+                        available < positions_size + changed_count * sizeof(double),
+                        "Sparse encoded message is truncated");
+
+                const std::byte *positions = data;
+                const std::byte *changed = data + positions_size;  // NOLINT
+
+                if (bitmap)
+                {
+                    std::size_t decoded = 0;
+                    for (std::size_t word_index = 0; word_index < positions_size / sizeof(uint64_t); ++word_index)
+                    {
+                        uint64_t word;
+                        positions = sparse_codec::copy(word, positions);
+
+                        while (0 != word)
+                        {
+                            const std::size_t index = word_index * 64 + static_cast<std::size_t>(__builtin_ctzll(word));
+                            word &= word - 1;
+
+                            SHARF_THROW_IF(
+                                    index >= count or decoded >= changed_count, "Invalid sparse encoded message");
+                            changed = sparse_codec::copy(previous_[index], changed);
+                            ++decoded;
+                        }
+                    }
+                    SHARF_THROW_IF(decoded != changed_count, "Invalid sparse encoded message");
+                }
+                else
+                {
+                    for (std::size_t i = 0; i < changed_count; ++i)
+                    {
+                        uint32_t index;
+                        positions = sparse_codec::copy(index, positions);
+
+                        SHARF_THROW_IF(index >= count, "Invalid sparse encoded message");
+                        changed = sparse_codec::copy(previous_[index], changed);
+                    }
+                }
+            }
+
+            message.values_.values() = previous_;
+        }
+    };
+}  // namespace pjmsg_mcap_wrapper
+
+
+namespace pjmsg_mcap_wrapper
+{
+    SparseDecoder::SparseDecoder() : pimpl_(std::make_unique<SparseDecoder::Implementation>())
+    {
+    }
+
+    SparseDecoder::~SparseDecoder() = default;
+
+    void SparseDecoder::reset()
+    {
+        pimpl_->previous_.clear();
+    }
+
+    void SparseDecoder::decode(const std::byte *data, const std::size_t size, Message &message)
+    {
+        pimpl_->decode(data, size, *message.pimpl_);
+    }
+
+    bool SparseDecoder::isKeyframe(const std::byte *data, const std::size_t size)
+    {
+        return (size > 0 and 0 != (static_cast<uint8_t>(data[0]) & sparse_codec::KEYFRAME));  // NOLINT
+    }
+}  // namespace pjmsg_mcap_wrapper
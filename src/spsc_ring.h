@@ -0,0 +1,174 @@
+/**
+    @file
+    @author Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#pragma once
+
+#include <atomic>
+#include <limits>
+#include <thread>
+#include <vector>
+
+namespace pjmsg_mcap_wrapper
+{
+    /**
+     * Lock-free single producer / single consumer ring of preallocated items.
+     * Items are never destroyed, so their memory (e.g., vector capacity) is
+     * reused on subsequent writes.
+     *
+     * The producer may also discard the oldest item with dropFront(), in
+     * this case the consumer must use take() instead of front() / pop().
+     */
+    template <class t_Item>
+    class SPSCRing
+    {
+    protected:
+        std::vector<t_Item> items_;
+
+        /// Incremented by producer only.
+        alignas(64) std::atomic<std::size_t> head_ = 0;
+        /// Incremented by consumer, or by producer in dropFront().
+        alignas(64) std::atomic<std::size_t> tail_ = 0;
+        /// Index of the item being copied by take().
+        std::atomic<std::size_t> reading_ = NOT_READING;
+
+    protected:
+        static constexpr std::size_t NOT_READING = std::numeric_limits<std::size_t>::max();
+
+    public:
+        void resize(const std::size_t size)
+        {
+            items_.resize(size);
+            head_ = 0;
+            tail_ = 0;
+        }
+
+        [[nodiscard]] std::size_t capacity() const
+        {
+            return (items_.size());
+        }
+
+        /// Number of published items, approximate if called by consumer.
+        [[nodiscard]] std::size_t size() const
+        {
+            return (head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire));
+        }
+
+        [[nodiscard]] bool empty() const
+        {
+            return (tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire));
+        }
+
+        /// All slots, may be accessed only while the ring is empty, e.g., to
+        /// preallocate their memory.
+        std::vector<t_Item> &items()
+        {
+            return (items_);
+        }
+
+
+        // producer
+
+        /// Free slot or nullptr if the ring is full.
+        t_Item *back()
+        {
+            const std::size_t head = head_.load(std::memory_order_relaxed);
+            if (head - tail_.load(std::memory_order_acquire) >= items_.size())
+            {
+                return (nullptr);
+            }
+            return (&items_[head % items_.size()]);
+        }
+
+        /// Publish slot returned by back().
+        void push()
+        {
+            head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        /**
+         * Discard the oldest item if the ring is full and the predicate
+         * accepts the item. Returns the discarded item, which becomes the
+         * slot returned by back(), or nullptr, e.g., if the consumer has
+         * released a slot in the meantime.
+         */
+        template <class t_Predicate>
+        t_Item *dropFront(const t_Predicate &predicate)
+        {
+            std::size_t tail = tail_.load(std::memory_order_seq_cst);
+            if (head_.load(std::memory_order_relaxed) - tail < items_.size()
+                or not predicate(items_[tail % items_.size()]))
+            {
+                return (nullptr);
+            }
+            if (not tail_.compare_exchange_strong(tail, tail + 1, std::memory_order_seq_cst))
+            {
+                return (nullptr);
+            }
+
+            // the consumer may have started copying the item before it was
+            // discarded, it is going to notice that and ignore the copy
+            while (reading_.load(std::memory_order_seq_cst) == tail)
+            {
+                std::this_thread::yield();
+            }
+            return (&items_[tail % items_.size()]);
+        }
+
+
+        // consumer
+
+        /// Oldest published item or nullptr if the ring is empty.
+        t_Item *front()
+        {
+            const std::size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail == head_.load(std::memory_order_acquire))
+            {
+                return (nullptr);
+            }
+            return (&items_[tail % items_.size()]);
+        }
+
+        /// Release slot returned by front().
+        void pop()
+        {
+            tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        /// Copy and release the oldest item, returns false if the ring is
+        /// empty. Safe to use concurrently with dropFront().
+        bool take(t_Item &item)
+        {
+            for (;;)
+            {
+                std::size_t tail = tail_.load(std::memory_order_seq_cst);
+                if (tail == head_.load(std::memory_order_acquire))
+                {
+                    return (false);
+                }
+
+                // announce before checking that the item is still there, see
+                // dropFront()
+                reading_.store(tail, std::memory_order_seq_cst);
+                if (tail_.load(std::memory_order_seq_cst) == tail)
+                {
+                    item = items_[tail % items_.size()];
+                    const bool taken = tail_.compare_exchange_strong(tail, tail + 1, std::memory_order_seq_cst);
+                    reading_.store(NOT_READING, std::memory_order_seq_cst);
+                    if (taken)
+                    {
+                        return (true);
+                    }
+                }
+                else
+                {
+                    reading_.store(NOT_READING, std::memory_order_seq_cst);
+                }
+            }
+        }
+    };
+}  // namespace pjmsg_mcap_wrapper
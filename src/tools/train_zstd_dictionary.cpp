@@ -0,0 +1,40 @@
+/**
+    @file
+    @author Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief Train ZSTD dictionary for Writer::Parameters::zstd_dictionary_.
+*/
+
+#include <pjmsg_mcap_wrapper/zstd_dictionary.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+
+int main(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        std::cerr << "Usage: " << argv[0] << " <dictionary> <max_size_bytes> <recording.mcap> [...]" << std::endl;
+        return (EXIT_FAILURE);
+    }
+
+    try
+    {
+        const std::vector<std::filesystem::path> recordings(argv + 3, argv + argc);  // NOLINT
+        const std::vector<std::byte> dictionary =
+                pjmsg_mcap_wrapper::ZstdDictionary::train(recordings, std::stoul(argv[2]));  // NOLINT
+        pjmsg_mcap_wrapper::ZstdDictionary::save(argv[1], dictionary);                    // NOLINT
+
+        std::cout << "Dictionary size: " << dictionary.size() << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return (EXIT_FAILURE);
+    }
+
+    return (EXIT_SUCCESS);
+}
@@ -0,0 +1,132 @@
+/**
+    @file
+    @author Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#pragma once
+
+#include <cstring>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#endif
+
+namespace pjmsg_mcap_wrapper
+{
+    /**
+     * Locates fields of plain CDR StatisticsValues or StatisticsValuesFloat32
+     * in place, without deserialization, see ValuesSerializer for layout.
+     * Values are not copied and may be unaligned.
+     */
+    template <class t_Value>
+    class ValuesView
+    {
+    protected:
+        static constexpr std::size_t ENCAPSULATION_SIZE = 4;
+        static constexpr std::size_t FRAME_ID_OFFSET = ENCAPSULATION_SIZE + sizeof(int32_t) + sizeof(uint32_t);
+
+    public:
+        const std::byte *values_ = nullptr;
+        uint32_t count_ = 0;
+        uint64_t stamp_ = 0;
+        uint32_t names_version_ = 0;
+
+    protected:
+        template <class t_Field>
+        static t_Field read(const std::byte *data)
+        {
+            t_Field field;
+            std::memcpy(&field, data, sizeof(field));
+            return (field);
+        }
+
+    public:
+        void parse(const std::byte *data, const std::size_t size)
+        {
+            SHARF_THROW_IF(size < FRAME_ID_OFFSET + sizeof(uint32_t), "StatisticsValues message is truncated");
+            // plain CDR in host byte order, options are ignored
+            const uint8_t representation =
+                    eprosima::fastcdr::Cdr::DEFAULT_ENDIAN == eprosima::fastcdr::Cdr::LITTLE_ENDIANNESS ? 0x01 : 0x00;
+            SHARF_THROW_IF(
+                    std::byte{ 0 } != data[0] or static_cast<std::byte>(representation) != data[1],
+                    "Unsupported CDR representation of StatisticsValues");
+
+            const int32_t sec = read<int32_t>(data + ENCAPSULATION_SIZE);          // NOLINT
+            const uint32_t nanosec = read<uint32_t>(data + ENCAPSULATION_SIZE + 4);  // NOLINT
+            stamp_ = static_cast<uint64_t>(sec) * std::nano::den + nanosec;
+
+            // frame_id length includes '\0', count is 4-aligned
+            std::size_t offset = FRAME_ID_OFFSET + sizeof(uint32_t) + read<uint32_t>(data + FRAME_ID_OFFSET);  // NOLINT
+            offset = (offset + 3) & ~std::size_t{ 3 };
+            SHARF_THROW_IF(offset + sizeof(uint32_t) > size, "StatisticsValues message is truncated");
+
+            count_ = read<uint32_t>(data + offset);  // NOLINT
+            offset += sizeof(uint32_t);
+            if (sizeof(t_Value) > 4 and count_ > 0)
+            {
+                // alignment is relative to the end of encapsulation
+                offset = ENCAPSULATION_SIZE + ((offset - ENCAPSULATION_SIZE + 7) & ~std::size_t{ 7 });
+            }
+            SHARF_THROW_IF(
+                    offset + std::size_t{ count_ } * sizeof(t_Value) + sizeof(uint32_t) > size,
+                    "StatisticsValues message is truncated");
+
+            values_ = data + offset;                                                // NOLINT
+            names_version_ = read<uint32_t>(values_ + count_ * sizeof(t_Value));  // NOLINT
+        }
+    };
+
+
+    /// output[i] = values[positions[i]], values may be unaligned.
+    template <class t_Value>
+    void gatherValues(const std::byte *values, const std::vector<int64_t> &positions, double *output)
+    {
+        std::size_t i = 0;
+#if defined(__AVX2__)
+        for (; i + 4 <= positions.size(); i += 4)
+        {
+            const __m256i indices = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&positions[i]));  // NOLINT
+            const t_Value *base = reinterpret_cast<const t_Value *>(values);                             // NOLINT
+            if constexpr (std::is_same_v<t_Value, double>)
+            {
+                _mm256_storeu_pd(output + i, _mm256_i64gather_pd(base, indices, sizeof(double)));  // NOLINT
+            }
+            else
+            {
+                const __m128 gathered = _mm256_i64gather_ps(base, indices, sizeof(float));
+                _mm256_storeu_pd(output + i, _mm256_cvtps_pd(gathered));  // NOLINT
+            }
+        }
+#endif
+        for (; i < positions.size(); ++i)
+        {
+            t_Value value;
+            std::memcpy(&value, values + positions[i] * static_cast<int64_t>(sizeof(value)), sizeof(value));  // NOLINT
+            output[i] = static_cast<double>(value);                                                            // NOLINT
+        }
+    }
+
+
+    /// Copy all values converting them to double.
+    template <class t_Value>
+    void copyValues(const std::byte *values, const std::size_t count, double *output)
+    {
+        if constexpr (std::is_same_v<t_Value, double>)
+        {
+            std::memcpy(output, values, count * sizeof(double));
+        }
+        else
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                t_Value value;
+                std::memcpy(&value, values + i * sizeof(t_Value), sizeof(value));  // NOLINT
+                output[i] = static_cast<double>(value);                            // NOLINT
+            }
+        }
+    }
+}  // namespace pjmsg_mcap_wrapper
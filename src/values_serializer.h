@@ -0,0 +1,174 @@
+/**
+    @file
+    @author Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#pragma once
+
+#include <cstring>
+#include <type_traits>
+
+#if defined(__AVX__)
+#    include <immintrin.h>
+#elif defined(__SSE2__)
+#    include <emmintrin.h>
+#endif
+
+namespace pjmsg_mcap_wrapper
+{
+    /// Convert doubles to floats, destination may be unaligned.
+    inline void convertToFloat(std::byte *destination, const double *values, const std::size_t count)
+    {
+        std::size_t i = 0;
+#if defined(__AVX__)
+        for (; i + 4 <= count; i += 4)
+        {
+            _mm_storeu_ps(
+                    reinterpret_cast<float *>(destination + i * sizeof(float)),  // NOLINT
+                    _mm256_cvtpd_ps(_mm256_loadu_pd(values + i)));               // NOLINT
+        }
+#elif defined(__SSE2__)
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128 low = _mm_cvtpd_ps(_mm_loadu_pd(values + i));       // NOLINT
+            const __m128 high = _mm_cvtpd_ps(_mm_loadu_pd(values + i + 2));  // NOLINT
+            _mm_storeu_ps(
+                    reinterpret_cast<float *>(destination + i * sizeof(float)),  // NOLINT
+                    _mm_movelh_ps(low, high));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            const float value = static_cast<float>(values[i]);                    // NOLINT
+            std::memcpy(destination + i * sizeof(float), &value, sizeof(value));  // NOLINT
+        }
+    }
+
+
+    /**
+     * Plain CDR (XCDRv1) serializer of StatisticsValues or
+     * StatisticsValuesFloat32, which bypasses FastCDR: message layout is
+     * fixed except for frame_id, so the header is encoded once and reused.
+     * Padding is zeroed, output is identical to FastCDR, see
+     * test/values_serializer.cpp. Input values are always doubles.
+     *
+     * Layout (offsets after encapsulation):
+     * sec | nanosec | frame_id length | frame_id + '\0' | pad to 4 |
+     * values count | pad to 8 if count > 0 and values are doubles | values |
+     * names_version
+     */
+    template <class t_Message = plotjuggler_msgs::msg::StatisticsValues>
+    class ValuesSerializer
+    {
+    protected:
+        using Value = typename std::decay_t<decltype(std::declval<t_Message>().values())>::value_type;
+
+    protected:
+        static constexpr std::size_t ENCAPSULATION_SIZE = 4;
+        static constexpr std::size_t SEC_OFFSET = ENCAPSULATION_SIZE;
+        static constexpr std::size_t NANOSEC_OFFSET = SEC_OFFSET + sizeof(int32_t);
+
+    protected:
+        /// Encapsulation, stamp, frame_id and padding.
+        std::vector<std::byte> header_;
+        std::string frame_id_;
+
+    protected:
+        void initialize(const std::string &frame_id)
+        {
+            frame_id_ = frame_id;
+
+            const std::size_t frame_id_size = frame_id.size() + 1;
+            const std::size_t size = (NANOSEC_OFFSET + sizeof(uint32_t) + sizeof(uint32_t) + frame_id_size + 3) & ~3U;
+
+            header_.assign(size, std::byte{ 0 });
+            // representation identifier, options are zero
+            header_[1] = static_cast<std::byte>(
+                    eprosima::fastcdr::Cdr::DEFAULT_ENDIAN == eprosima::fastcdr::Cdr::LITTLE_ENDIANNESS ? 0x01 : 0x00);
+
+            const uint32_t length = static_cast<uint32_t>(frame_id_size);
+            std::memcpy(&header_[NANOSEC_OFFSET + sizeof(uint32_t)], &length, sizeof(length));
+            std::memcpy(&header_[NANOSEC_OFFSET + 2 * sizeof(uint32_t)], frame_id.data(), frame_id.size());
+        }
+
+        [[nodiscard]] std::size_t getPadding(const std::size_t count) const
+        {
+            // doubles are 8-aligned relative to the end of encapsulation,
+            // floats are always aligned after the count
+            if (sizeof(Value) < 8 or 0 == count)
+            {
+                return (0);
+            }
+            return ((0 != (header_.size() + sizeof(uint32_t) - ENCAPSULATION_SIZE) % 8) ? 4 : 0);
+        }
+
+    public:
+        /// Must be called before serialization to update the header.
+        uint32_t getSize(const std::string &frame_id, const std::size_t count)
+        {
+            if (header_.empty() or frame_id != frame_id_)
+            {
+                initialize(frame_id);
+            }
+
+            return (static_cast<uint32_t>(
+                    header_.size() + sizeof(uint32_t) + getPadding(count) + count * sizeof(Value) + sizeof(uint32_t)));
+        }
+
+        uint32_t getSize(const plotjuggler_msgs::msg::StatisticsValues &message)
+        {
+            return (getSize(message.header().frame_id(), message.values().size()));
+        }
+
+        /// Buffer must have getSize() bytes.
+        void serialize(
+                std::byte *buffer,
+                const int32_t sec,
+                const uint32_t nanosec,
+                const double *values,
+                const uint32_t count,
+                const uint32_t names_version)
+        {
+            std::memcpy(buffer, header_.data(), header_.size());
+            std::memcpy(buffer + SEC_OFFSET, &sec, sizeof(sec));              // NOLINT
+            std::memcpy(buffer + NANOSEC_OFFSET, &nanosec, sizeof(nanosec));  // NOLINT
+            buffer += header_.size();                                         // NOLINT
+
+            std::memcpy(buffer, &count, sizeof(count));
+            buffer += sizeof(count);  // NOLINT
+
+            const std::size_t padding = getPadding(count);
+            std::memset(buffer, 0, padding);
+            buffer += padding;  // NOLINT
+
+            if (count > 0)
+            {
+                if constexpr (std::is_same_v<Value, double>)
+                {
+                    std::memcpy(buffer, values, count * sizeof(double));
+                }
+                else
+                {
+                    convertToFloat(buffer, values, count);
+                }
+                buffer += count * sizeof(Value);  // NOLINT
+            }
+
+            std::memcpy(buffer, &names_version, sizeof(names_version));
+        }
+
+        void serialize(std::byte *buffer, const plotjuggler_msgs::msg::StatisticsValues &message)
+        {
+            serialize(
+                    buffer,
+                    message.header().stamp().sec(),
+                    message.header().stamp().nanosec(),
+                    message.values().data(),
+                    static_cast<uint32_t>(message.values().size()),
+                    message.names_version());
+        }
+    };
+}  // namespace pjmsg_mcap_wrapper
@@ -11,22 +11,50 @@
 #include "util.h"
 #include "message_impl.h"
 #include "plotjuggler_msgs.h"
+#include "spsc_ring.h"
+#include "mcap_writer.h"
+#include "values_serializer.h"
+#include "clock.h"
+#include "file_rotator.h"
+#include "xor_codec.h"
+#include "sparse_codec.h"
 
-#pragma GCC diagnostic push
-/// @todo presumably GCC bug
-#pragma GCC diagnostic ignored "-Warray-bounds"
-#include <mcap/writer.hpp>
-#pragma GCC diagnostic pop
+#include <algorithm>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+#include <variant>
 
 
 namespace
 {
-    uint64_t now()
+    uint64_t steadyNow()
     {
         return (std::chrono::duration_cast<std::chrono::nanoseconds>(
-                        std::chrono::system_clock::now().time_since_epoch())
+                        std::chrono::steady_clock::now().time_since_epoch())
                         .count());
     }
+
+    mcap::CompressionLevel getCompressionLevel(const pjmsg_mcap_wrapper::Writer::Parameters::CompressionLevel level)
+    {
+        using CompressionLevel = pjmsg_mcap_wrapper::Writer::Parameters::CompressionLevel;
+
+        switch (level)
+        {
+            case CompressionLevel::FASTEST:
+                return (mcap::CompressionLevel::Fastest);
+            case CompressionLevel::FAST:
+                return (mcap::CompressionLevel::Fast);
+            case CompressionLevel::SLOW:
+                return (mcap::CompressionLevel::Slow);
+            case CompressionLevel::SLOWEST:
+                return (mcap::CompressionLevel::Slowest);
+            case CompressionLevel::DEFAULT:
+            default:
+                return (mcap::CompressionLevel::Default);
+        }
+    }
 }  // namespace
 
 
@@ -35,12 +63,20 @@ namespace pjmsg_mcap_wrapper
     class Writer::Implementation
     {
     protected:
-        template <class t_Message>
+        /// t_Message is written as t_Encoded, which may differ only for
+        /// StatisticsValues.
+        template <class t_Message, class t_Encoded = t_Message>
         class Channel
         {
         protected:
             mcap::Message message_;
             eprosima::fastcdr::CdrSizeCalculator cdr_size_calculator_;
+            /// FastCDR is bypassed for StatisticsValues.
+            std::conditional_t<
+                    std::is_same_v<t_Message, plotjuggler_msgs::msg::StatisticsValues>,
+                    ValuesSerializer<t_Encoded>,
+                    std::monostate>
+                    values_serializer_;
 
         protected:
             uint32_t getSize(const t_Message &message)
@@ -55,12 +91,12 @@ namespace pjmsg_mcap_wrapper
             {
             }
 
-            void initialize(mcap::McapWriter &writer, const std::string_view &msg_topic)
+            void initialize(McapWriter &writer, const std::string_view &msg_topic)
             {
                 mcap::Schema schema(
-                        pjmsg_mcap_wrapper_private::pjmsg::Message<t_Message>::type,
+                        pjmsg_mcap_wrapper_private::pjmsg::Message<t_Encoded>::type,
                         "ros2msg",
-                        pjmsg_mcap_wrapper_private::pjmsg::Message<t_Message>::schema);
+                        pjmsg_mcap_wrapper_private::pjmsg::Message<t_Encoded>::schema);
                 writer.addSchema(schema);
 
                 mcap::Channel channel(msg_topic, "ros2msg", schema.id);
@@ -69,45 +105,1042 @@ namespace pjmsg_mcap_wrapper
                 message_.channelId = channel.id;
             }
 
-            void write(mcap::McapWriter &writer, std::vector<std::byte> &buffer, const t_Message &message)
+            void write(
+                    McapWriter &writer,
+                    std::vector<std::byte> &buffer,
+                    const t_Message &message,
+                    const uint64_t timestamp)
             {
-                buffer.resize(getSize(message));
-                message_.data = buffer.data();
+                message_.logTime = timestamp;
+                message_.publishTime = message_.logTime;
 
+                if constexpr (std::is_same_v<t_Message, plotjuggler_msgs::msg::StatisticsValues>)
                 {
-                    eprosima::fastcdr::FastBuffer cdr_buffer(
-                            reinterpret_cast<char *>(buffer.data()), buffer.size());  // NOLINT
-                    eprosima::fastcdr::Cdr ser(
-                            cdr_buffer, eprosima::fastcdr::Cdr::DEFAULT_ENDIAN, eprosima::fastcdr::CdrVersion::XCDRv1);
-                    ser.set_encoding_flag(eprosima::fastcdr::EncodingAlgorithmFlag::PLAIN_CDR);
+                    // serialized directly to the chunk buffer
+                    message_.dataSize = values_serializer_.getSize(message);
+                    writer.write(
+                            message_, [this, &message](std::byte *payload)
+                            { values_serializer_.serialize(payload, message); });
+                }
+                else
+                {
+                    buffer.resize(getSize(message));
+                    message_.data = buffer.data();
+
+                    {
+                        eprosima::fastcdr::FastBuffer cdr_buffer(
+                                reinterpret_cast<char *>(buffer.data()), buffer.size());  // NOLINT
+                        eprosima::fastcdr::Cdr ser(
+                                cdr_buffer,
+                                eprosima::fastcdr::Cdr::DEFAULT_ENDIAN,
+                                eprosima::fastcdr::CdrVersion::XCDRv1);
+                        ser.set_encoding_flag(eprosima::fastcdr::EncodingAlgorithmFlag::PLAIN_CDR);
+
+                        ser.serialize_encapsulation();
+                        ser << message;
+                        ser.set_dds_cdr_options({ 0, 0 });
 
-                    ser.serialize_encapsulation();
-                    ser << message;
-                    ser.set_dds_cdr_options({ 0, 0 });
+                        message_.dataSize = ser.get_serialized_data_length();
+                    }
 
-                    message_.dataSize = ser.get_serialized_data_length();
+                    writer.write(message_);
                 }
+            }
 
-                message_.logTime = now();
+            /// StatisticsValues only
+            void writeBatch(
+                    McapWriter &writer,
+                    const t_Message &message,
+                    const double *values,
+                    const uint64_t *timestamps,
+                    const std::size_t samples,
+                    const uint64_t timestamp,
+                    const uint64_t *log_times)
+            {
+                message_.logTime = timestamp;
                 message_.publishTime = message_.logTime;
 
+                const std::size_t size = message.values().size();
+                const uint32_t names_version = message.names_version();
 
-                const mcap::Status res = writer.write(message_);
-                SHARF_THROW_IF(not res.ok(), "Failed to write a message: ", res.message);
+                message_.dataSize = values_serializer_.getSize(message.header().frame_id(), size);
+                writer.write(
+                        message_,
+                        samples,
+                        [&](const std::size_t index, std::byte *payload)
+                        {
+                            values_serializer_.serialize(
+                                    payload,
+                                    static_cast<int32_t>(timestamps[index] / std::nano::den),
+                                    static_cast<uint32_t>(timestamps[index] % std::nano::den),
+                                    values + index * size,  // NOLINT
+                                    static_cast<uint32_t>(size),
+                                    names_version);
+                        },
+                        log_times);
+            }
+        };
+
+        /// Values encoded with t_Encoder, see xor_codec.h and sparse_codec.h.
+        template <class t_Encoder>
+        class EncodedChannel
+        {
+        protected:
+            mcap::Message message_;
+            t_Encoder encoder_;
+            uint64_t chunk_sequence_ = 0;
+
+        public:
+            void initialize(
+                    McapWriter &writer,
+                    const std::string_view &msg_topic,
+                    mcap::Schema schema,
+                    const std::size_t keyframe_interval)
+            {
+                writer.addSchema(schema);
+
+                mcap::Channel channel(msg_topic, schema.encoding, schema.id);
+                writer.addChannel(channel);
+
+                message_.channelId = channel.id;
+                encoder_.keyframe_interval_ = keyframe_interval;
+            }
+
+            /// Next message is going to be a keyframe.
+            void reset()
+            {
+                encoder_.reset();
+            }
+
+            void write(
+                    McapWriter &writer,
+                    const std::string &frame_id,
+                    const int32_t sec,
+                    const uint32_t nanosec,
+                    const double *values,
+                    const uint32_t count,
+                    const uint32_t names_version,
+                    const uint64_t timestamp)
+            {
+                message_.logTime = timestamp;
+                message_.publishTime = message_.logTime;
+
+                const bool keyframe = encoder_.needsKeyframe(count);
+                const std::vector<std::byte> *data =
+                        &encoder_.encode(frame_id, sec, nanosec, values, count, names_version, keyframe);
+                message_.dataSize = data->size();
+
+                // chunks must be decodable independently
+                if (not keyframe and writer.getChunkSequence(message_) != chunk_sequence_)
+                {
+                    data = &encoder_.encode(frame_id, sec, nanosec, values, count, names_version, true);
+                    message_.dataSize = data->size();
+                }
+                message_.data = data->data();
+                chunk_sequence_ = writer.getChunkSequence(message_);
+
+                writer.write(message_);
+            }
+
+            void write(
+                    McapWriter &writer,
+                    const plotjuggler_msgs::msg::StatisticsValues &message,
+                    const uint64_t timestamp)
+            {
+                write(writer,
+                      message.header().frame_id(),
+                      message.header().stamp().sec(),
+                      message.header().stamp().nanosec(),
+                      message.values().data(),
+                      static_cast<uint32_t>(message.values().size()),
+                      message.names_version(),
+                      timestamp);
             }
         };
 
     public:
-        std::tuple<Channel<plotjuggler_msgs::msg::StatisticsNames>, Channel<plotjuggler_msgs::msg::StatisticsValues>>
-                channels_;
+        /// Messages dropped in async mode between two queued messages.
+        class Gap
+        {
+        public:
+            uint64_t count_ = 0;
+            /// Range of log times of dropped messages.
+            uint64_t first_time_ = 0;
+            uint64_t last_time_ = 0;
+
+        public:
+            void add(const Gap &gap) noexcept
+            {
+                if (0 == gap.count_)
+                {
+                    return;
+                }
+
+                if (0 == count_)
+                {
+                    first_time_ = gap.first_time_;
+                    last_time_ = gap.last_time_;
+                }
+                else
+                {
+                    first_time_ = std::min(first_time_, gap.first_time_);
+                    last_time_ = std::max(last_time_, gap.last_time_);
+                }
+                count_ += gap.count_;
+            }
+
+            void add(const uint64_t timestamp) noexcept
+            {
+                add(Gap{ 1, timestamp, timestamp });
+            }
+        };
+
+        /// JSON markers of gaps on '<topic_prefix>/dropped'.
+        class GapChannel
+        {
+        protected:
+            mcap::Message message_;
+            std::string data_;
+
+        public:
+            void initialize(McapWriter &writer, const std::string_view &msg_topic)
+            {
+                mcap::Schema schema(
+                        "pjmsg_mcap_wrapper/Dropped",
+                        "jsonschema",
+                        R"({"type":"object","properties":{"count":{"type":"integer"},)"
+                        R"("first_time":{"type":"integer"},"last_time":{"type":"integer"}}})");
+                writer.addSchema(schema);
+
+                mcap::Channel channel(msg_topic, "json", schema.id);
+                writer.addChannel(channel);
+
+                message_.channelId = channel.id;
+            }
+
+            void write(McapWriter &writer, const Gap &gap)
+            {
+                data_ = str_concat(
+                        R"({"count":)",
+                        std::to_string(gap.count_),
+                        R"(,"first_time":)",
+                        std::to_string(gap.first_time_),
+                        R"(,"last_time":)",
+                        std::to_string(gap.last_time_),
+                        "}");
+
+                // placed where the data is missing
+                message_.logTime = gap.first_time_;
+                message_.publishTime = message_.logTime;
+                message_.data = reinterpret_cast<const std::byte *>(data_.data());  // NOLINT
+                message_.dataSize = data_.size();
+
+                writer.write(message_);
+            }
+        };
+
+        /// Message snapshot passed to the background thread.
+        class Sample
+        {
+        public:
+            plotjuggler_msgs::msg::StatisticsNames names_;
+            plotjuggler_msgs::msg::StatisticsValues values_;
+            uint64_t timestamp_;
+            bool names_updated_;
+            /// Messages dropped before this one.
+            Gap gap_;
+        };
+
+        /// Channels of a topic prefix and staging queue of its producer.
+        class Stream
+        {
+        public:
+            std::tuple<
+                    Channel<plotjuggler_msgs::msg::StatisticsNames>,
+                    Channel<plotjuggler_msgs::msg::StatisticsValues>,
+                    Channel<plotjuggler_msgs::msg::StatisticsValues, plotjuggler_msgs::msg::StatisticsValuesFloat32>>
+                    channels_;
+            EncodedChannel<xor_codec::Encoder> xor_channel_;
+            EncodedChannel<sparse_codec::Encoder> sparse_channel_;
+            GapChannel gap_channel_;
+            SPSCRing<Sample> queue_;
+            std::string topic_prefix_;
+
+            /// Minimum interval between messages and the earliest time of
+            /// the next one, updated by the producer only.
+            uint64_t period_ = 0;
+            uint64_t next_time_ = 0;
+
+            /// Dropped messages that are not yet attached to a queued
+            /// message, updated by the producer only.
+            Gap gap_;
+            std::size_t decimation_counter_ = 0;
+            /// Oldest sample copied from the queue in DROP_OLDEST mode.
+            Sample staged_;
+            bool has_staged_ = false;
+
+            /// tryWrite() counters, updated by the producer only.
+            std::atomic<uint64_t> queued_ = 0;
+            std::atomic<uint64_t> overflows_ = 0;
+            std::atomic<uint64_t> rejected_ = 0;
+            /// Timestamp of the last queued sample, updated by the producer
+            /// only.
+            std::atomic<uint64_t> newest_timestamp_ = 0;
+            /// Producer waits for a free slot, see
+            /// Implementation::waitForSlot().
+            std::atomic<bool> waiting_ = false;
+
+            /// Last names, re-emitted in flight recorder mode, since the
+            /// recorded copy can be dropped, and at the beginning of each
+            /// file in rotation mode.
+            plotjuggler_msgs::msg::StatisticsNames names_;
+            uint64_t names_timestamp_ = 0;
+            bool has_names_ = false;
+
+        public:
+            void initialize(McapWriter &writer, const Writer::Parameters &params)
+            {
+                std::get<Channel<plotjuggler_msgs::msg::StatisticsNames>>(channels_).initialize(
+                        writer, str_concat(topic_prefix_, "/names"));
+
+                switch (params.values_encoding_)
+                {
+                    case Writer::Parameters::ValuesEncoding::XOR:
+                        xor_channel_.initialize(
+                                writer,
+                                str_concat(topic_prefix_, "/values_xor"),
+                                mcap::Schema(xor_codec::SCHEMA_NAME, xor_codec::MESSAGE_ENCODING, xor_codec::SCHEMA),
+                                params.xor_keyframe_interval_);
+                        break;
+                    case Writer::Parameters::ValuesEncoding::FLOAT32:
+                        getFloat32Channel().initialize(writer, str_concat(topic_prefix_, "/values"));
+                        break;
+                    case Writer::Parameters::ValuesEncoding::SPARSE:
+                        sparse_channel_.initialize(
+                                writer,
+                                str_concat(topic_prefix_, "/values_sparse"),
+                                mcap::Schema(
+                                        sparse_codec::SCHEMA_NAME,
+                                        sparse_codec::MESSAGE_ENCODING,
+                                        sparse_codec::SCHEMA),
+                                params.sparse_keyframe_interval_);
+                        break;
+                    case Writer::Parameters::ValuesEncoding::CDR:
+                    default:
+                        std::get<Channel<plotjuggler_msgs::msg::StatisticsValues>>(channels_).initialize(
+                                writer, str_concat(topic_prefix_, "/values"));
+                        break;
+                }
+
+                if (params.async_)
+                {
+                    gap_channel_.initialize(writer, str_concat(topic_prefix_, "/dropped"));
+                }
+            }
+
+            /// Message is not skipped due to the stream period.
+            bool isDue(const uint64_t timestamp) noexcept
+            {
+                if (0 == period_)
+                {
+                    return (true);
+                }
+                if (timestamp < next_time_)
+                {
+                    return (false);
+                }
+                next_time_ = timestamp + period_;
+                return (true);
+            }
+
+            template <class t_Message>
+            Channel<t_Message> &getChannel()
+            {
+                return (std::get<Channel<t_Message>>(channels_));
+            }
+
+            Channel<plotjuggler_msgs::msg::StatisticsValues, plotjuggler_msgs::msg::StatisticsValuesFloat32> &
+            getFloat32Channel()
+            {
+                return (std::get<Channel<
+                                plotjuggler_msgs::msg::StatisticsValues,
+                                plotjuggler_msgs::msg::StatisticsValuesFloat32>>(channels_));
+            }
+        };
+
+    protected:
+        std::thread thread_;
+        std::chrono::microseconds async_period_;
+        uint64_t merge_window_ = 0;
+        Writer::Parameters::Backpressure backpressure_ = Writer::Parameters::Backpressure::BLOCK;
+        std::size_t decimation_ = 2;
+        std::atomic<bool> stop_ = false;
+        std::atomic<bool> flush_requested_ = false;
+        std::atomic<bool> trigger_requested_ = false;
+        std::atomic<bool> failed_ = false;
+        /// Producers blocked on full queues.
+        std::mutex slot_mutex_;
+        std::condition_variable slot_condition_;
+        /// McapWriterParameters::max_chunk_latency_ (nanoseconds).
+        uint64_t max_chunk_latency_ = 0;
+        std::exception_ptr error_;
+
+        /// Streams registered with addStream() followed by the default one.
+        std::vector<std::unique_ptr<Stream>> streams_;
+        std::unordered_map<const Message::Implementation *, Stream *> stream_map_;
+
+        Writer::Parameters::ValuesEncoding values_encoding_ = Writer::Parameters::ValuesEncoding::CDR;
+
+        /// Flight recorder mode.
+        bool recorder_ = false;
+        uint64_t recorder_post_duration_ = 0;
+        uint64_t recorder_deadline_ = std::numeric_limits<uint64_t>::max();
+        /// File is closed after the post-trigger window.
+        bool finished_ = false;
 
+        /// File rotation mode.
+        bool rotation_ = false;
+        uint64_t rotation_size_ = 0;
+        uint64_t rotation_duration_ = 0;
+        uint64_t file_start_time_ = std::numeric_limits<uint64_t>::max();
+        FileRotator rotator_;
+        /// Schemas and channels for new files.
+        McapWriter prototype_;
+
+    public:
         std::vector<std::byte> buffer_;
-        mcap::McapWriter writer_;
+        std::unique_ptr<McapWriter> writer_ = std::make_unique<McapWriter>();
+        Clock clock_;
+
+    protected:
+        void writeGap(Stream &stream, const Gap &gap)
+        {
+            if (not finished_ and gap.count_ > 0)
+            {
+                stream.gap_channel_.write(*writer_, gap);
+            }
+        }
+
+        void writeSample(Stream &stream, const Sample &sample)
+        {
+            writeGap(stream, sample.gap_);
+            if (sample.names_updated_)
+            {
+                write(stream, sample.names_, sample.timestamp_);
+            }
+            write(stream, sample.values_, sample.timestamp_);
+        }
+
+        /// Current time for the merge window: message stamps are not
+        /// related to the clock, so the newest queued stamp is used instead.
+        [[nodiscard]] uint64_t getMergeHorizon() const
+        {
+            if (not clock_.useMessageStamp())
+            {
+                return (clock_.now());
+            }
+
+            uint64_t horizon = 0;
+            for (const std::unique_ptr<Stream> &stream : streams_)
+            {
+                horizon = std::max(horizon, stream->newest_timestamp_.load(std::memory_order_relaxed));
+            }
+            return (horizon);
+        }
+
+        /**
+         * Write queued samples ordered by timestamps across streams. The
+         * oldest sample can be written immediately if all active streams
+         * have pending samples, otherwise only after merge window expires,
+         * since an idle producer may still push an older sample.
+         */
+        void drain(const bool all)
+        {
+            const uint64_t horizon =
+                    (all or 1 == streams_.size()) ? std::numeric_limits<uint64_t>::max() : getMergeHorizon();
+
+            for (;;)
+            {
+                Stream *next_stream = nullptr;
+                Sample *next_sample = nullptr;
+                bool complete = true;
+
+                for (const std::unique_ptr<Stream> &stream : streams_)
+                {
+                    Sample *sample = peek(*stream);
+                    if (nullptr == sample)
+                    {
+                        // streams that have never been written to, e.g., the
+                        // default one when all messages are added with
+                        // addStream(), are not waited for
+                        if (stream->queued_.load(std::memory_order_relaxed) > 0)
+                        {
+                            complete = false;
+                        }
+                    }
+                    else
+                    {
+                        if (nullptr == next_sample or sample->timestamp_ < next_sample->timestamp_)
+                        {
+                            next_stream = stream.get();
+                            next_sample = sample;
+                        }
+                    }
+                }
+
+                if (nullptr == next_sample or (not complete and next_sample->timestamp_ + merge_window_ > horizon))
+                {
+                    break;
+                }
+
+                writeSample(*next_stream, *next_sample);
+                release(*next_stream);
+            }
+        }
+
+        /// Wake up the producer of the stream if it waits for a free slot.
+        void notifyProducer(Stream &stream)
+        {
+            // pairs with the fence in waitForSlot(): either the producer
+            // sees the released slot or the consumer sees the flag
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (stream.waiting_.load(std::memory_order_relaxed))
+            {
+                {
+                    const std::lock_guard<std::mutex> lock(slot_mutex_);
+                }
+                slot_condition_.notify_all();
+            }
+        }
+
+        /// Oldest queued sample of the stream or nullptr.
+        Sample *peek(Stream &stream)
+        {
+            if (Writer::Parameters::Backpressure::DROP_OLDEST != backpressure_)
+            {
+                return (stream.queue_.front());
+            }
+
+            // the producer may discard queued samples, so they are copied out
+            if (not stream.has_staged_)
+            {
+                stream.has_staged_ = stream.queue_.take(stream.staged_);
+                if (stream.has_staged_)
+                {
+                    notifyProducer(stream);
+                }
+            }
+            return (stream.has_staged_ ? &stream.staged_ : nullptr);
+        }
+
+        /// Release sample returned by peek().
+        void release(Stream &stream)
+        {
+            if (Writer::Parameters::Backpressure::DROP_OLDEST != backpressure_)
+            {
+                stream.queue_.pop();
+                notifyProducer(stream);
+            }
+            else
+            {
+                stream.has_staged_ = false;
+            }
+        }
+
+        void run()
+        {
+            try
+            {
+                for (;;)
+                {
+                    // read before draining: everything queued before stop
+                    // request must be written
+                    const bool stop = stop_.load(std::memory_order_acquire);
+
+                    drain(stop);
+                    writer_->closeExpiredChunk(steadyNow());
+
+                    if (flush_requested_.exchange(false, std::memory_order_acq_rel))
+                    {
+                        writer_->flush();
+                    }
+
+                    if (recorder_)
+                    {
+                        if (trigger_requested_.exchange(false, std::memory_order_acq_rel))
+                        {
+                            trigger();
+                        }
+                        closeRecording();
+                    }
+
+                    if (stop)
+                    {
+                        break;
+                    }
+
+                    std::this_thread::sleep_for(async_period_);
+                }
+            }
+            catch (...)
+            {
+                error_ = std::current_exception();
+                failed_.store(true, std::memory_order_release);
+
+                // blocked producers must rethrow the error
+                {
+                    const std::lock_guard<std::mutex> lock(slot_mutex_);
+                }
+                slot_condition_.notify_all();
+            }
+        }
+
+        void stop()
+        {
+            if (thread_.joinable())
+            {
+                stop_.store(true, std::memory_order_release);
+                thread_.join();
+
+                if (not failed_.load(std::memory_order_acquire))
+                {
+                    // gaps that are not followed by queued messages
+                    for (const std::unique_ptr<Stream> &stream : streams_)
+                    {
+                        writeGap(*stream, stream->gap_);
+                    }
+                }
+            }
+        }
+
+        static void increment(std::atomic<uint64_t> &counter) noexcept
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        static void drop(Stream &stream, const uint64_t timestamp) noexcept
+        {
+            increment(stream.overflows_);
+            stream.gap_.add(timestamp);
+        }
+
+        /**
+         * Free queue slot or nullptr if the message is dropped according to
+         * the backpressure policy. Queued messages with names are never
+         * dropped, names of dropped messages are passed on by the caller.
+         */
+        Sample *getSlot(Stream &stream, const uint64_t timestamp)
+        {
+            using Backpressure = Writer::Parameters::Backpressure;
+
+            if (Backpressure::DECIMATE == backpressure_ and 2 * stream.queue_.size() >= stream.queue_.capacity()
+                and 0 != stream.decimation_counter_++ % decimation_)
+            {
+                drop(stream, timestamp);
+                return (nullptr);
+            }
+
+            Sample *sample = stream.queue_.back();
+            while (nullptr == sample)
+            {
+                switch (backpressure_)
+                {
+                    case Backpressure::DROP_NEWEST:
+                    case Backpressure::DECIMATE:
+                        drop(stream, timestamp);
+                        return (nullptr);
+
+                    case Backpressure::DROP_OLDEST:
+                    {
+                        const Sample *dropped = stream.queue_.dropFront(
+                                [](const Sample &oldest) { return (not oldest.names_updated_); });
+                        if (nullptr != dropped)
+                        {
+                            drop(stream, dropped->timestamp_);
+                            stream.gap_.add(dropped->gap_);
+                        }
+                        break;
+                    }
+
+                    case Backpressure::BLOCK:
+                    default:
+                        break;
+                }
+
+                throwIfFailed();
+                sample = stream.queue_.back();
+                if (nullptr == sample)
+                {
+                    waitForSlot(stream);
+                    sample = stream.queue_.back();
+                }
+            }
+            return (sample);
+        }
+
+        /**
+         * Sleep until the background thread releases a slot of the stream
+         * or fails. Wakeup is also bounded by the background thread period,
+         * so that the caller may recheck the backpressure policy.
+         */
+        void waitForSlot(Stream &stream)
+        {
+            std::unique_lock<std::mutex> lock(slot_mutex_);
+
+            stream.waiting_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            slot_condition_.wait_for(
+                    lock,
+                    async_period_,
+                    [this, &stream]()
+                    { return (nullptr != stream.queue_.back() or failed_.load(std::memory_order_acquire)); });
+
+            stream.waiting_.store(false, std::memory_order_relaxed);
+        }
+
+        /// Publish sample obtained with getSlot().
+        static void push(Stream &stream, Sample &sample) noexcept
+        {
+            sample.gap_ = stream.gap_;
+            stream.gap_ = Gap();
+
+            stream.queue_.push();
+            increment(stream.queued_);
+            stream.newest_timestamp_.store(sample.timestamp_, std::memory_order_relaxed);
+        }
+
+        static bool fits(const std::string &slot, const std::string &value) noexcept
+        {
+            return (value.size() <= slot.capacity());
+        }
+
+        /// Message can be copied to the slot without memory allocation.
+        static bool fits(const Sample &sample, const Message::Implementation &message) noexcept
+        {
+            if (not fits(sample.values_.header().frame_id(), message.values_.header().frame_id())
+                or message.values_.values().size() > sample.values_.values().capacity())
+            {
+                return (false);
+            }
+
+            if (message.version_updated_)
+            {
+                // existing strings are reused, new strings would be allocated
+                const std::vector<std::string> &slot_names = sample.names_.names();
+                const std::vector<std::string> &names = message.names_.names();
+
+                if (not fits(sample.names_.header().frame_id(), message.names_.header().frame_id())
+                    or names.size() > slot_names.size())
+                {
+                    return (false);
+                }
+                for (std::size_t i = 0; i < names.size(); ++i)
+                {
+                    if (not fits(slot_names[i], names[i]))
+                    {
+                        return (false);
+                    }
+                }
+            }
+
+            return (true);
+        }
 
     public:
         ~Implementation()
         {
-            writer_.close();
+            try
+            {
+                close();
+            }
+            catch (...)
+            {
+                // errors are reported by Writer::close()
+            }
+        }
+
+        void close()
+        {
+            stop();
+            writer_->close();
+            rotator_.stop();
+            throwIfFailed();
+        }
+
+        [[nodiscard]] bool isAsync() const
+        {
+            return (thread_.joinable());
+        }
+
+        void throwIfFailed()
+        {
+            if (failed_.load(std::memory_order_acquire))
+            {
+                std::rethrow_exception(error_);
+            }
+        }
+
+        uint64_t getTimestamp(const Message::Implementation &message) const
+        {
+            if (clock_.useMessageStamp())
+            {
+                const builtin_interfaces::msg::Time &stamp = message.values_.header().stamp();
+                return (static_cast<uint64_t>(stamp.sec()) * std::nano::den + stamp.nanosec());
+            }
+            return (clock_.now());
+        }
+
+        Stream &getStream(const Message::Implementation &message)
+        {
+            if (not stream_map_.empty())
+            {
+                const auto iterator = stream_map_.find(&message);
+                if (stream_map_.end() != iterator)
+                {
+                    return (*iterator->second);
+                }
+            }
+            return (*streams_.back());
+        }
+
+        void addStream(
+                const Message::Implementation &message,
+                const std::string &topic_prefix,
+                const Writer::StreamParameters &params)
+        {
+            // the default stream is not in the map
+            SHARF_THROW_IF(stream_map_.size() != streams_.size(), "Streams must be added before initialization");
+            SHARF_THROW_IF(stream_map_.end() != stream_map_.find(&message), "Message is already added");
+
+            streams_.push_back(std::make_unique<Stream>());
+            streams_.back()->topic_prefix_ = topic_prefix;
+            streams_.back()->period_ = static_cast<uint64_t>(params.period_.count());
+            stream_map_[&message] = streams_.back().get();
+        }
+
+        /// Copy message to the queue, returns false if it is dropped.
+        bool enqueue(Stream &stream, const Message::Implementation &message, const uint64_t timestamp)
+        {
+            Sample *sample = getSlot(stream, timestamp);
+            if (nullptr == sample)
+            {
+                return (false);
+            }
+
+            sample->names_updated_ = message.version_updated_;
+            if (message.version_updated_)
+            {
+                sample->names_ = message.names_;
+            }
+            sample->values_ = message.values_;
+            sample->timestamp_ = timestamp;
+
+            push(stream, *sample);
+            return (true);
+        }
+
+        void reserve(Stream &stream, const Message::Implementation &message)
+        {
+            SHARF_THROW_IF(not isAsync(), "Queue slots can only be reserved in async mode");
+
+            // slots of queued messages are read by the background thread
+            while (not stream.queue_.empty())
+            {
+                throwIfFailed();
+                std::this_thread::yield();
+            }
+
+            for (Sample &sample : stream.queue_.items())
+            {
+                sample.names_ = message.names_;
+                sample.values_.header().frame_id().reserve(message.values_.header().frame_id().size());
+                sample.values_.values().reserve(message.values_.values().size());
+            }
+        }
+
+        /// Copy message to the queue if it fits into a free slot.
+        bool tryEnqueue(Stream &stream, const Message::Implementation &message, const uint64_t timestamp) noexcept
+        {
+            if (not isAsync() or failed_.load(std::memory_order_acquire))
+            {
+                increment(stream.rejected_);
+                return (false);
+            }
+
+            Sample *sample = stream.queue_.back();
+            if (nullptr == sample)
+            {
+                drop(stream, timestamp);
+                return (false);
+            }
+            if (not fits(*sample, message))
+            {
+                increment(stream.rejected_);
+                stream.gap_.add(timestamp);
+                return (false);
+            }
+
+            sample->names_updated_ = message.version_updated_;
+            if (message.version_updated_)
+            {
+                sample->names_ = message.names_;
+            }
+            sample->values_ = message.values_;
+            sample->timestamp_ = timestamp;
+
+            push(stream, *sample);
+            return (true);
+        }
+
+        [[nodiscard]] Writer::QueueStatistics getQueueStatistics() const
+        {
+            Writer::QueueStatistics statistics;
+            for (const std::unique_ptr<Stream> &stream : streams_)
+            {
+                statistics.queued_ += stream->queued_.load(std::memory_order_relaxed);
+                statistics.overflows_ += stream->overflows_.load(std::memory_order_relaxed);
+                statistics.rejected_ += stream->rejected_.load(std::memory_order_relaxed);
+            }
+            return (statistics);
+        }
+
+        /// Returns false if names were not queued since all samples were
+        /// dropped.
+        bool enqueueBatch(
+                Stream &stream,
+                const Message::Implementation &message,
+                const double *values,
+                const uint64_t *timestamps,
+                const std::size_t samples,
+                const uint64_t timestamp)
+        {
+            const std::size_t size = message.values_.values().size();
+            bool names_pending = message.version_updated_;
+
+            for (std::size_t i = 0; i < samples; ++i)
+            {
+                if (not stream.isDue(timestamps[i]))
+                {
+                    continue;
+                }
+
+                const uint64_t log_time = clock_.useMessageStamp() ? timestamps[i] : timestamp;
+
+                Sample *sample = getSlot(stream, log_time);
+                if (nullptr == sample)
+                {
+                    continue;
+                }
+
+                sample->names_updated_ = names_pending;
+                if (names_pending)
+                {
+                    sample->names_ = message.names_;
+                    names_pending = false;
+                }
+                sample->values_.header().frame_id() = message.values_.header().frame_id();
+                sample->values_.header().stamp().sec(static_cast<int32_t>(timestamps[i] / std::nano::den));
+                sample->values_.header().stamp().nanosec(static_cast<uint32_t>(timestamps[i] % std::nano::den));
+                sample->values_.values().assign(values + i * size, values + (i + 1) * size);  // NOLINT
+                sample->values_.names_version(message.values_.names_version());
+                sample->timestamp_ = log_time;
+
+                push(stream, *sample);
+            }
+
+            return (not names_pending);
+        }
+
+        /**
+         * Synchronous mode: McapWriter::closeExpiredChunk() expects monotonic
+         * time, log time is reused if it is CLOCK_MONOTONIC based, otherwise
+         * the coarse clock is read; async mode uses CLOCK_MONOTONIC as well.
+         */
+        void closeExpiredChunk(const uint64_t timestamp)
+        {
+            if (max_chunk_latency_ > 0)
+            {
+                writer_->closeExpiredChunk(clock_.isMonotonic() ? timestamp : Clock::coarseNow());
+            }
+        }
+
+        void requestFlush()
+        {
+            flush_requested_.store(true, std::memory_order_release);
+        }
+
+        [[nodiscard]] bool isRecorder() const
+        {
+            return (recorder_);
+        }
+
+        void requestTrigger()
+        {
+            trigger_requested_.store(true, std::memory_order_release);
+        }
+
+        void trigger()
+        {
+            if (not writer_->isRecording())
+            {
+                return;
+            }
+
+            writer_->trigger(
+                    [this]()
+                    {
+                        for (const std::unique_ptr<Stream> &stream : streams_)
+                        {
+                            if (stream->has_names_)
+                            {
+                                stream->getChannel<plotjuggler_msgs::msg::StatisticsNames>().write(
+                                        *writer_, buffer_, stream->names_, stream->names_timestamp_);
+                            }
+                        }
+                    });
+            recorder_deadline_ = clock_.now() + recorder_post_duration_;
+        }
+
+        /// Switch to the next file if the current one exceeds limits.
+        void rotate(const uint64_t timestamp)
+        {
+            if (std::numeric_limits<uint64_t>::max() == file_start_time_)
+            {
+                file_start_time_ = timestamp;
+                return;
+            }
+
+            if ((rotation_size_ > 0 and writer_->fileSize() >= rotation_size_)
+                or (rotation_duration_ > 0 and timestamp >= file_start_time_ + rotation_duration_))
+            {
+                rotator_.rotate(writer_);
+                file_start_time_ = timestamp;
+
+                for (const std::unique_ptr<Stream> &stream : streams_)
+                {
+                    stream->xor_channel_.reset();
+                    stream->sparse_channel_.reset();
+
+                    if (stream->has_names_)
+                    {
+                        stream->getChannel<plotjuggler_msgs::msg::StatisticsNames>().write(
+                                *writer_, buffer_, stream->names_, timestamp);
+                    }
+                }
+            }
+        }
+
+        /// Close the file when post-trigger window expires, the clock is read
+        /// only after trigger.
+        void closeRecording()
+        {
+            if (std::numeric_limits<uint64_t>::max() != recorder_deadline_ and not finished_
+                and clock_.now() >= recorder_deadline_)
+            {
+                writer_->close();
+                finished_ = true;
+            }
         }
 
         void initialize(
@@ -115,42 +1148,239 @@ namespace pjmsg_mcap_wrapper
                 const std::string &topic_prefix,
                 const Writer::Parameters &params)
         {
+            clock_.initialize(params.clock_);
+
             {
-                mcap::McapWriterOptions options = mcap::McapWriterOptions("ros2msg");
+                McapWriter::Parameters writer_params;
+
+                writer_params.options_.compressionLevel = getCompressionLevel(params.compression_level_);
+                writer_params.options_.chunkSize = params.chunk_size_;
+                writer_params.options_.noChunkCRC = not params.chunk_crc_;
+                writer_params.options_.enableDataCRC = params.data_crc_;
+                writer_params.options_.noSummaryCRC = not params.summary_crc_;
+                writer_params.options_.noMessageIndex = not params.message_index_;
+                writer_params.options_.noSummary = not params.summary_;
 
                 // Set compression based on parameters
                 switch (params.compression_)
                 {
                     case Writer::Parameters::Compression::ZSTD:
-                        options.noChunking = false;
-                        options.compression = mcap::Compression::Zstd;
+                        writer_params.options_.noChunking = false;
+                        writer_params.options_.compression = mcap::Compression::Zstd;
+                        writer_params.zstd_dictionary_ = params.zstd_dictionary_;
+                        writer_params.adaptive_compression_ = params.adaptive_compression_;
+                        writer_params.streaming_compression_ = params.streaming_compression_;
+                        break;
+                    case Writer::Parameters::Compression::LZ4:
+                        writer_params.options_.noChunking = false;
+                        writer_params.options_.compression = mcap::Compression::Lz4;
+                        if (Writer::Parameters::CompressionLevel::DEFAULT == params.compression_level_)
+                        {
+                            // default level of MCAP maps to slow LZ4HC
+                            writer_params.options_.compressionLevel = mcap::CompressionLevel::Fast;
+                        }
                         break;
                     case Writer::Parameters::Compression::NONE:
                     default:
-                        options.noChunking = true;
-                        options.compression = mcap::Compression::None;
+                        writer_params.options_.noChunking = true;
+                        writer_params.options_.compression = mcap::Compression::None;
                         break;
                 }
 
-                const mcap::Status res = writer_.open(filename.native(), options);
-                if (not res.ok())
+                recorder_ = params.recorder_size_ > 0 or params.recorder_duration_.count() > 0;
+                if (recorder_)
+                {
+                    // recorded messages are kept in chunks
+                    writer_params.options_.noChunking = false;
+                    writer_params.ring_size_ = params.recorder_size_;
+                    writer_params.ring_duration_ = static_cast<uint64_t>(
+                            std::chrono::duration_cast<std::chrono::nanoseconds>(params.recorder_duration_).count());
+                    recorder_post_duration_ = static_cast<uint64_t>(
+                            std::chrono::duration_cast<std::chrono::nanoseconds>(params.recorder_post_duration_)
+                                    .count());
+                }
+                writer_params.compression_threads_ = params.compression_threads_;
+                writer_params.shuffle_ = Parameters::ChunkFilter::SHUFFLE == params.chunk_filter_;
+                writer_params.max_chunk_latency_ = static_cast<uint64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(params.max_chunk_latency_).count());
+                max_chunk_latency_ = writer_params.max_chunk_latency_;
+
+                rotation_size_ = params.rotation_size_;
+                rotation_duration_ = static_cast<uint64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(params.rotation_duration_).count());
+                rotation_ = rotation_size_ > 0 or rotation_duration_ > 0;
+                SHARF_THROW_IF(rotation_ and recorder_, "File rotation is not supported in flight recorder mode");
+
+                if (rotation_)
+                {
+                    rotator_.setFilename(filename);
+                    writer_->open(rotator_.getFilename(0), writer_params);
+                }
+                else
+                {
+                    writer_->open(filename.native(), writer_params);
+                }
+                writer_->write(clock_.getMetadata());
+
+                values_encoding_ = params.values_encoding_;
+
+                streams_.push_back(std::make_unique<Stream>());
+                streams_.back()->topic_prefix_ = topic_prefix;
+                for (const std::unique_ptr<Stream> &stream : streams_)
+                {
+                    stream->initialize(*writer_, params);
+                }
+
+                if (rotation_)
                 {
-                    throw std::runtime_error(
-                            str_concat("Failed to open ", filename.native(), " for writing: ", res.message));
+                    prototype_.copyDefinitions(*writer_);
+                    rotator_.start(
+                            [this, writer_params](McapWriter &writer, const std::string &rotated_filename)
+                            {
+                                writer.copyDefinitions(prototype_);
+                                writer.open(rotated_filename, writer_params);
+                                writer.write(clock_.getMetadata());
+                            });
                 }
             }
 
-            std::get<Channel<plotjuggler_msgs::msg::StatisticsNames>>(channels_).initialize(
-                    writer_, str_concat(topic_prefix, "/names"));
+            if (params.async_)
+            {
+                SHARF_THROW_IF(0 == params.async_queue_size_, "Async queue size must be positive");
 
-            std::get<Channel<plotjuggler_msgs::msg::StatisticsValues>>(channels_).initialize(
-                    writer_, str_concat(topic_prefix, "/values"));
+                for (const std::unique_ptr<Stream> &stream : streams_)
+                {
+                    stream->queue_.resize(params.async_queue_size_);
+                }
+                async_period_ = params.async_period_;
+                backpressure_ = params.backpressure_;
+                decimation_ = params.decimation_;
+                SHARF_THROW_IF(
+                        Parameters::Backpressure::DECIMATE == backpressure_ and 0 == decimation_,
+                        "Decimation factor must be positive");
+                merge_window_ = static_cast<uint64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(params.merge_window_).count());
+                thread_ = std::thread(&Implementation::run, this);
+            }
         }
 
         template <class t_Message>
-        void write(const t_Message &message)
+        void write(Stream &stream, const t_Message &message, const uint64_t timestamp)
         {
-            std::get<Channel<t_Message>>(channels_).write(writer_, buffer_, message);
+            if (finished_)
+            {
+                return;
+            }
+            if (rotation_)
+            {
+                rotate(timestamp);
+            }
+
+            if constexpr (std::is_same_v<t_Message, plotjuggler_msgs::msg::StatisticsNames>)
+            {
+                if (rotation_ or writer_->isRecording())
+                {
+                    stream.names_ = message;
+                    stream.names_timestamp_ = timestamp;
+                    stream.has_names_ = true;
+                }
+            }
+
+            if constexpr (std::is_same_v<t_Message, plotjuggler_msgs::msg::StatisticsValues>)
+            {
+                switch (values_encoding_)
+                {
+                    case Writer::Parameters::ValuesEncoding::XOR:
+                        stream.xor_channel_.write(*writer_, message, timestamp);
+                        return;
+                    case Writer::Parameters::ValuesEncoding::SPARSE:
+                        stream.sparse_channel_.write(*writer_, message, timestamp);
+                        return;
+                    case Writer::Parameters::ValuesEncoding::FLOAT32:
+                        stream.getFloat32Channel().write(*writer_, buffer_, message, timestamp);
+                        return;
+                    case Writer::Parameters::ValuesEncoding::CDR:
+                    default:
+                        break;
+                }
+            }
+
+            stream.getChannel<t_Message>().write(*writer_, buffer_, message, timestamp);
+        }
+
+        /// Encoding is sequential, rows are written one by one.
+        template <class t_Channel>
+        void writeEncodedBatch(
+                t_Channel &channel,
+                const plotjuggler_msgs::msg::StatisticsValues &message,
+                const double *values,
+                const uint64_t *timestamps,
+                const std::size_t samples,
+                const uint64_t timestamp)
+        {
+            const std::size_t size = message.values().size();
+            for (std::size_t i = 0; i < samples; ++i)
+            {
+                channel.write(
+                        *writer_,
+                        message.header().frame_id(),
+                        static_cast<int32_t>(timestamps[i] / std::nano::den),
+                        static_cast<uint32_t>(timestamps[i] % std::nano::den),
+                        values + i * size,  // NOLINT
+                        static_cast<uint32_t>(size),
+                        message.names_version(),
+                        clock_.useMessageStamp() ? timestamps[i] : timestamp);
+            }
+        }
+
+        void writeBatch(
+                Stream &stream,
+                const plotjuggler_msgs::msg::StatisticsValues &message,
+                const double *values,
+                const uint64_t *timestamps,
+                const std::size_t samples,
+                const uint64_t timestamp)
+        {
+            if (finished_)
+            {
+                return;
+            }
+            if (rotation_)
+            {
+                rotate(timestamp);
+            }
+
+            switch (values_encoding_)
+            {
+                case Writer::Parameters::ValuesEncoding::XOR:
+                    writeEncodedBatch(stream.xor_channel_, message, values, timestamps, samples, timestamp);
+                    return;
+                case Writer::Parameters::ValuesEncoding::SPARSE:
+                    writeEncodedBatch(stream.sparse_channel_, message, values, timestamps, samples, timestamp);
+                    return;
+                case Writer::Parameters::ValuesEncoding::FLOAT32:
+                    stream.getFloat32Channel().writeBatch(
+                            *writer_,
+                            message,
+                            values,
+                            timestamps,
+                            samples,
+                            timestamp,
+                            clock_.useMessageStamp() ? timestamps : nullptr);
+                    return;
+                case Writer::Parameters::ValuesEncoding::CDR:
+                default:
+                    break;
+            }
+
+            stream.getChannel<plotjuggler_msgs::msg::StatisticsValues>().writeBatch(
+                    *writer_,
+                    message,
+                    values,
+                    timestamps,
+                    samples,
+                    timestamp,
+                    clock_.useMessageStamp() ? timestamps : nullptr);
         }
     };
 }  // namespace pjmsg_mcap_wrapper
@@ -164,6 +1394,11 @@ namespace pjmsg_mcap_wrapper
 
     Writer::~Writer() = default;
 
+    void Writer::close()
+    {
+        pimpl_->close();
+    }
+
     void Writer::initialize(
             const std::filesystem::path &filename,
             const std::string &topic_prefix,
@@ -172,19 +1407,149 @@ namespace pjmsg_mcap_wrapper
         pimpl_->initialize(filename, topic_prefix, params);
     }
 
+    void Writer::addStream(const Message &message, const std::string &topic_prefix, const StreamParameters &params)
+    {
+        pimpl_->addStream(*message.pimpl_, topic_prefix, params);
+    }
+
     void Writer::flush()
     {
-        // pimpl_->writer_.closeLastChunk();
-        pimpl_->writer_.dataSink()->flush();
+        if (pimpl_->isAsync())
+        {
+            pimpl_->throwIfFailed();
+            pimpl_->requestFlush();
+        }
+        else
+        {
+            pimpl_->writer_->flush();
+        }
+    }
+
+    void Writer::trigger()
+    {
+        SHARF_THROW_IF(not pimpl_->isRecorder(), "Writer is not in flight recorder mode");
+
+        if (pimpl_->isAsync())
+        {
+            pimpl_->throwIfFailed();
+            pimpl_->requestTrigger();
+        }
+        else
+        {
+            pimpl_->trigger();
+            pimpl_->closeRecording();
+        }
     }
 
     void Writer::write(const Message &message)
     {
+        const uint64_t timestamp = pimpl_->getTimestamp(*message.pimpl_);
+        Implementation::Stream &stream = pimpl_->getStream(*message.pimpl_);
+
+        if (not stream.isDue(timestamp))
+        {
+            return;
+        }
+
+        if (pimpl_->isAsync())
+        {
+            pimpl_->throwIfFailed();
+            if (pimpl_->enqueue(stream, *message.pimpl_, timestamp))
+            {
+                message.pimpl_->version_updated_ = false;
+            }
+            return;
+        }
+
         if (message.pimpl_->version_updated_)
         {
-            pimpl_->write(message.pimpl_->names_);
+            pimpl_->write(stream, message.pimpl_->names_, timestamp);
             message.pimpl_->version_updated_ = false;
         }
-        pimpl_->write(message.pimpl_->values_);
+        pimpl_->write(stream, message.pimpl_->values_, timestamp);
+        pimpl_->closeExpiredChunk(timestamp);
+        pimpl_->closeRecording();
+    }
+
+    void Writer::reserve(const Message &message)
+    {
+        pimpl_->reserve(pimpl_->getStream(*message.pimpl_), *message.pimpl_);
+    }
+
+    bool Writer::tryWrite(const Message &message) noexcept
+    {
+        const uint64_t timestamp = pimpl_->getTimestamp(*message.pimpl_);
+        Implementation::Stream &stream = pimpl_->getStream(*message.pimpl_);
+
+        if (not stream.isDue(timestamp))
+        {
+            return (false);
+        }
+        if (not pimpl_->tryEnqueue(stream, *message.pimpl_, timestamp))
+        {
+            return (false);
+        }
+        message.pimpl_->version_updated_ = false;
+        return (true);
+    }
+
+    Writer::QueueStatistics Writer::getQueueStatistics() const
+    {
+        return (pimpl_->getQueueStatistics());
+    }
+
+    void Writer::writeBatch(
+            const Message &message,
+            const double *values,
+            const uint64_t *timestamps,
+            const std::size_t samples)
+    {
+        if (0 == samples)
+        {
+            return;
+        }
+
+        const uint64_t timestamp = pimpl_->clock_.useMessageStamp() ? timestamps[0] : pimpl_->clock_.now();
+        Implementation::Stream &stream = pimpl_->getStream(*message.pimpl_);
+
+        if (pimpl_->isAsync())
+        {
+            pimpl_->throwIfFailed();
+            if (pimpl_->enqueueBatch(stream, *message.pimpl_, values, timestamps, samples, timestamp))
+            {
+                message.pimpl_->version_updated_ = false;
+            }
+            return;
+        }
+
+        if (0 == stream.period_)
+        {
+            if (message.pimpl_->version_updated_)
+            {
+                pimpl_->write(stream, message.pimpl_->names_, timestamp);
+                message.pimpl_->version_updated_ = false;
+            }
+            pimpl_->writeBatch(stream, message.pimpl_->values_, values, timestamps, samples, timestamp);
+        }
+        else
+        {
+            const std::size_t size = message.pimpl_->values_.values().size();
+            for (std::size_t i = 0; i < samples; ++i)
+            {
+                if (stream.isDue(timestamps[i]))
+                {
+                    const uint64_t log_time = pimpl_->clock_.useMessageStamp() ? timestamps[i] : timestamp;
+                    if (message.pimpl_->version_updated_)
+                    {
+                        pimpl_->write(stream, message.pimpl_->names_, log_time);
+                        message.pimpl_->version_updated_ = false;
+                    }
+                    pimpl_->writeBatch(
+                            stream, message.pimpl_->values_, values + i * size, &timestamps[i], 1, log_time);  // NOLINT
+                }
+            }
+        }
+        pimpl_->closeExpiredChunk(timestamp);
+        pimpl_->closeRecording();
     }
 }  // namespace pjmsg_mcap_wrapper
@@ -0,0 +1,262 @@
+/**
+    @file
+    @author Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#pragma once
+
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace pjmsg_mcap_wrapper
+{
+    /**
+     * XOR (Gorilla) encoding of StatisticsValues, each signal is encoded
+     * against its value in the previous message of the same channel.
+     *
+     * Message layout (host byte order):
+     * flags (uint8) | sec (int32) | nanosec (uint32) | names_version (uint32)
+     * | values count (uint32) | frame_id length (uint32) | frame_id |
+     * bit stream packed LSB first in 64 bit words.
+     *
+     * Keyframes contain raw 64 bit values, otherwise each value is encoded as
+     * - '0' -- same as previous;
+     * - '1' '0' meaningful bits -- XOR with the previous value fits in the
+     *   window of leading / trailing zeros of the previous XOR;
+     * - '1' '1' leading zeros (6 bits) | meaningful bits count - 1 (6 bits)
+     *   | meaningful bits -- new window.
+     */
+    namespace xor_codec
+    {
+        inline const char *const MESSAGE_ENCODING = "pjmsg_xor";
+        inline const char *const SCHEMA_NAME = "pjmsg_mcap_wrapper/XorStatisticsValues";
+        inline const char *const SCHEMA = "XOR encoded plotjuggler_msgs/msg/StatisticsValues, see "
+                                          "pjmsg_mcap_wrapper::XorDecoder";
+
+        constexpr uint8_t KEYFRAME = 0x01;
+        constexpr std::size_t HEADER_SIZE = sizeof(uint8_t) + sizeof(int32_t) + 4 * sizeof(uint32_t);
+        /// Maximum encoded size of a value in bits.
+        constexpr std::size_t MAX_VALUE_BITS = 2 + 6 + 6 + 64;
+        /// Window is not initialized.
+        constexpr uint8_t NO_WINDOW = std::numeric_limits<uint8_t>::max();
+
+
+        class BitWriter
+        {
+        protected:
+            std::byte *data_;
+            uint64_t word_ = 0;
+            std::size_t used_ = 0;
+
+        public:
+            explicit BitWriter(std::byte *data) : data_(data)
+            {
+            }
+
+            /// Write size (1..64) lower bits of value, other bits must be
+            /// zero.
+            void write(const uint64_t value, const std::size_t size)
+            {
+                word_ |= value << used_;
+                if (used_ + size >= 64)
+                {
+                    std::memcpy(data_, &word_, sizeof(word_));
+                    data_ += sizeof(word_);  // NOLINT
+                    word_ = (0 == used_) ? 0 : value >> (64 - used_);
+                    used_ = used_ + size - 64;
+                }
+                else
+                {
+                    used_ += size;
+                }
+            }
+
+            /// Returns pointer past the last written byte.
+            std::byte *finish()
+            {
+                const std::size_t size = (used_ + 7) / 8;
+                std::memcpy(data_, &word_, size);
+                return (data_ + size);  // NOLINT
+            }
+        };
+
+
+        class BitReader
+        {
+        protected:
+            const std::byte *data_;
+            const std::byte *end_;
+            uint64_t word_ = 0;
+            std::size_t available_ = 0;
+
+        protected:
+            static uint64_t mask(const std::size_t size)
+            {
+                return (64 == size ? std::numeric_limits<uint64_t>::max() : (uint64_t{ 1 } << size) - 1);
+            }
+
+        public:
+            BitReader(const std::byte *data, const std::byte *end) : data_(data), end_(end)
+            {
+            }
+
+            uint64_t read(const std::size_t size)
+            {
+                if (available_ >= size)
+                {
+                    const uint64_t value = word_ & mask(size);
+                    word_ = (64 == size) ? 0 : word_ >> size;
+                    available_ -= size;
+                    return (value);
+                }
+
+                if (data_ >= end_)
+                {
+                    throw std::runtime_error("XOR encoded message is truncated");
+                }
+
+                uint64_t word = 0;
+                const std::size_t word_size =
+                        std::min(sizeof(word), static_cast<std::size_t>(end_ - data_));  // NOLINT
+                std::memcpy(&word, data_, word_size);
+                data_ += word_size;  // NOLINT
+
+                const uint64_t value = (word_ | (word << available_)) & mask(size);
+                const std::size_t consumed = size - available_;
+                word_ = (64 == consumed) ? 0 : word >> consumed;
+                available_ = 64 - consumed;
+
+                return (value);
+            }
+        };
+
+
+        template <class t_Value>
+        std::byte *copy(std::byte *buffer, const t_Value &value)
+        {
+            std::memcpy(buffer, &value, sizeof(value));
+            return (buffer + sizeof(value));  // NOLINT
+        }
+
+        template <class t_Value>
+        const std::byte *copy(t_Value &value, const std::byte *buffer)
+        {
+            std::memcpy(&value, buffer, sizeof(value));
+            return (buffer + sizeof(value));  // NOLINT
+        }
+
+
+        /// Encoder state of a channel.
+        class Encoder
+        {
+        protected:
+            std::vector<uint64_t> previous_;
+            std::vector<uint8_t> leading_;
+            std::vector<uint8_t> trailing_;
+            std::size_t since_keyframe_ = 0;
+
+            std::vector<std::byte> buffer_;
+
+        public:
+            /// Keyframe is written at least every this many messages.
+            std::size_t keyframe_interval_ = 100;
+
+        public:
+            /// Next message is going to be a keyframe.
+            void reset()
+            {
+                previous_.clear();
+            }
+
+            [[nodiscard]] bool needsKeyframe(const std::size_t count) const
+            {
+                return (previous_.size() != count or previous_.empty() or since_keyframe_ >= keyframe_interval_);
+            }
+
+            const std::vector<std::byte> &encode(
+                    const std::string &frame_id,
+                    const int32_t sec,
+                    const uint32_t nanosec,
+                    const double *values,
+                    const uint32_t count,
+                    const uint32_t names_version,
+                    const bool keyframe)
+            {
+                buffer_.resize(HEADER_SIZE + frame_id.size() + (count * MAX_VALUE_BITS + 63) / 64 * sizeof(uint64_t));
+
+                std::byte *data = buffer_.data();
+                data = copy(data, keyframe ? KEYFRAME : uint8_t{ 0 });
+                data = copy(data, sec);
+                data = copy(data, nanosec);
+                data = copy(data, names_version);
+                data = copy(data, count);
+                data = copy(data, static_cast<uint32_t>(frame_id.size()));
+                std::memcpy(data, frame_id.data(), frame_id.size());
+                data += frame_id.size();  // NOLINT
+
+                BitWriter bits(data);
+                if (keyframe)
+                {
+                    previous_.resize(count);
+                    leading_.assign(count, NO_WINDOW);
+                    trailing_.assign(count, 0);
+                    since_keyframe_ = 0;
+
+                    for (std::size_t i = 0; i < count; ++i)
+                    {
+                        std::memcpy(&previous_[i], &values[i], sizeof(uint64_t));  // NOLINT
+                        bits.write(previous_[i], 64);
+                    }
+                }
+                else
+                {
+                    ++since_keyframe_;
+
+                    for (std::size_t i = 0; i < count; ++i)
+                    {
+                        uint64_t value;
+                        std::memcpy(&value, &values[i], sizeof(value));  // NOLINT
+
+                        const uint64_t xored = value ^ previous_[i];
+                        previous_[i] = value;
+
+                        if (0 == xored)
+                        {
+                            bits.write(0, 1);
+                            continue;
+                        }
+
+                        const uint8_t leading = static_cast<uint8_t>(__builtin_clzll(xored));
+                        const uint8_t trailing = static_cast<uint8_t>(__builtin_ctzll(xored));
+
+                        if (NO_WINDOW != leading_[i] and leading >= leading_[i] and trailing >= trailing_[i])
+                        {
+                            bits.write(0b01, 2);
+                            bits.write(xored >> trailing_[i], 64 - leading_[i] - trailing_[i]);
+                        }
+                        else
+                        {
+                            const std::size_t meaningful = 64 - leading - trailing;
+
+                            bits.write(0b11, 2);
+                            bits.write(leading, 6);
+                            bits.write(meaningful - 1, 6);
+                            bits.write(xored >> trailing, meaningful);
+
+                            leading_[i] = leading;
+                            trailing_[i] = trailing;
+                        }
+                    }
+                }
+
+                buffer_.resize(static_cast<std::size_t>(bits.finish() - buffer_.data()));
+                return (buffer_);
+            }
+        };
+    }  // namespace xor_codec
+}  // namespace pjmsg_mcap_wrapper
@@ -0,0 +1,129 @@
+/**
+    @file
+    @author Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#include "pjmsg_mcap_wrapper/xor_decoder.h"
+#include "3rdparty.h"
+#include "util.h"
+#include "message_impl.h"
+#include "xor_codec.h"
+
+
+namespace pjmsg_mcap_wrapper
+{
+    class XorDecoder::Implementation
+    {
+    public:
+        std::vector<uint64_t> previous_;
+        std::vector<uint8_t> leading_;
+        std::vector<uint8_t> trailing_;
+
+    public:
+        void decode(const std::byte *data, const std::size_t size, Message::Implementation &message)
+        {
+            SHARF_THROW_IF(size < xor_codec::HEADER_SIZE, "XOR encoded message is truncated");
+
+            const std::byte *const end = data + size;  // NOLINT
+
+            uint8_t flags;
+            int32_t sec;
+            uint32_t nanosec;
+            uint32_t names_version;
+            uint32_t count;
+            uint32_t frame_id_size;
+
+            data = xor_codec::copy(flags, data);
+            data = xor_codec::copy(sec, data);
+            data = xor_codec::copy(nanosec, data);
+            data = xor_codec::copy(names_version, data);
+            data = xor_codec::copy(count, data);
+            data = xor_codec::copy(frame_id_size, data);
+
+            SHARF_THROW_IF(frame_id_size > static_cast<std::size_t>(end - data), "XOR encoded message is truncated");
+            message.values_.header().frame_id().assign(reinterpret_cast<const char *>(data), frame_id_size);  // NOLINT
+            data += frame_id_size;                                                                              // NOLINT
+
+            message.values_.header().stamp().sec(sec);
+            message.values_.header().stamp().nanosec(nanosec);
+            message.names_.header().stamp().sec(sec);
+            message.names_.header().stamp().nanosec(nanosec);
+            message.setVersion(names_version);
+
+            std::vector<double> &values = message.values_.values();
+            values.resize(count);
+
+            xor_codec::BitReader bits(data, end);
+            if (0 != (flags & xor_codec::KEYFRAME))
+            {
+                previous_.resize(count);
+                leading_.assign(count, xor_codec::NO_WINDOW);
+                trailing_.assign(count, 0);
+
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    previous_[i] = bits.read(64);
+                }
+            }
+            else
+            {
+                SHARF_THROW_IF(previous_.empty() and count > 0, "XOR encoded message without preceding keyframe");
+                SHARF_THROW_IF(previous_.size() != count, "XOR encoded message size does not match keyframe");
+
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    if (0 == bits.read(1))
+                    {
+                        continue;
+                    }
+
+                    if (0 == bits.read(1))
+                    {
+                        SHARF_THROW_IF(xor_codec::NO_WINDOW == leading_[i], "Invalid XOR encoded message");
+                        previous_[i] ^= bits.read(64 - leading_[i] - trailing_[i]) << trailing_[i];
+                    }
+                    else
+                    {
+                        const std::size_t leading = bits.read(6);
+                        const std::size_t meaningful = bits.read(6) + 1;
+                        SHARF_THROW_IF(leading + meaningful > 64, "Invalid XOR encoded message");
+
+                        leading_[i] = static_cast<uint8_t>(leading);
+                        trailing_[i] = static_cast<uint8_t>(64 - leading - meaningful);
+                        previous_[i] ^= bits.read(meaningful) << trailing_[i];
+                    }
+                }
+            }
+
+            std::memcpy(values.data(), previous_.data(), count * sizeof(double));
+        }
+    };
+}  // namespace pjmsg_mcap_wrapper
+
+
+namespace pjmsg_mcap_wrapper
+{
+    XorDecoder::XorDecoder() : pimpl_(std::make_unique<XorDecoder::Implementation>())
+    {
+    }
+
+    XorDecoder::~XorDecoder() = default;
+
+    void XorDecoder::reset()
+    {
+        pimpl_->previous_.clear();
+    }
+
+    void XorDecoder::decode(const std::byte *data, const std::size_t size, Message &message)
+    {
+        pimpl_->decode(data, size, *message.pimpl_);
+    }
+
+    bool XorDecoder::isKeyframe(const std::byte *data, const std::size_t size)
+    {
+        return (size > 0 and 0 != (static_cast<uint8_t>(data[0]) & xor_codec::KEYFRAME));  // NOLINT
+    }
+}  // namespace pjmsg_mcap_wrapper
@@ -0,0 +1,138 @@
+/**
+    @file
+    @author Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#include "pjmsg_mcap_wrapper/zstd_dictionary.h"
+#include "pjmsg_mcap_wrapper/chunk_decoder.h"
+#include "3rdparty.h"
+#include "util.h"
+#include "mcap_writer.h"
+
+#include <fstream>
+
+#include <mcap/reader.hpp>
+#include <zdict.h>
+
+#include "mcap_records.h"
+
+
+namespace
+{
+    /// ZSTD recommends ~100 times more samples than dictionary size.
+    constexpr std::size_t SAMPLES_PER_DICTIONARY_SIZE = 100;
+}  // namespace
+
+
+namespace pjmsg_mcap_wrapper
+{
+    std::vector<std::byte> ZstdDictionary::train(
+            const std::vector<std::filesystem::path> &recordings,
+            const std::size_t size)
+    {
+        const std::size_t max_samples_size = SAMPLES_PER_DICTIONARY_SIZE * size;
+
+        std::vector<std::byte> samples;
+        std::vector<std::size_t> sample_sizes;
+        ChunkDecoder decoder;
+        for (const std::filesystem::path &recording : recordings)
+        {
+            mcap_records::visitRecords(
+                    recording,
+                    decoder,
+                    [&](const mcap::OpCode opcode, const std::byte *data, const uint64_t data_size)
+                    {
+                        if (mcap::OpCode::Message == opcode)
+                        {
+                            samples.insert(samples.end(), data, data + data_size);  // NOLINT
+                            sample_sizes.push_back(data_size);
+                        }
+                        return (samples.size() < max_samples_size);
+                    });
+
+            if (samples.size() >= max_samples_size)
+            {
+                break;
+            }
+        }
+
+        std::vector<std::byte> dictionary(size);
+        const std::size_t result = ZDICT_trainFromBuffer(
+                dictionary.data(), dictionary.size(), samples.data(), sample_sizes.data(),
+                static_cast<unsigned>(sample_sizes.size()));
+        SHARF_THROW_IF(ZDICT_isError(result), "ZSTD dictionary training failed: ", ZDICT_getErrorName(result));
+        dictionary.resize(result);
+
+        return (dictionary);
+    }
+
+
+    std::vector<std::byte> ZstdDictionary::read(const std::filesystem::path &recording)
+    {
+        const mcap_records::FilePtr file = mcap_records::openFile(recording);
+        mcap::FileReader input(file.get());
+        mcap::RecordReader reader(input, sizeof(mcap::Magic));
+
+        // Writer stores the dictionary before chunks
+        for (std::optional<mcap::Record> record = reader.next(); record; record = reader.next())
+        {
+            switch (record->opcode)
+            {
+                case mcap::OpCode::Attachment:
+                {
+                    mcap::Attachment attachment;
+                    const mcap::Status status = mcap::McapReader::ParseAttachment(*record, &attachment);
+                    SHARF_THROW_IF(not status.ok(), "Failed to parse attachment: ", status.message);
+
+                    if (McapWriter::ZSTD_DICTIONARY_ATTACHMENT == attachment.name)
+                    {
+                        return (std::vector<std::byte>(
+                                attachment.data, attachment.data + attachment.dataSize));  // NOLINT
+                    }
+                    break;
+                }
+
+                case mcap::OpCode::Chunk:
+                case mcap::OpCode::Message:
+                case mcap::OpCode::DataEnd:
+                case mcap::OpCode::Footer:
+                    return (std::vector<std::byte>());
+
+                default:
+                    break;
+            }
+        }
+
+        SHARF_THROW_IF(not reader.status().ok(), "Failed to read ", recording.native(), ": ", reader.status().message);
+        return (std::vector<std::byte>());
+    }
+
+
+    std::vector<std::byte> ZstdDictionary::load(const std::filesystem::path &filename)
+    {
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        SHARF_THROW_IF(not file.is_open(), "Failed to open ", filename.native());
+
+        std::vector<std::byte> dictionary(static_cast<std::size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char *>(dictionary.data()), static_cast<std::streamsize>(dictionary.size()));  // NOLINT
+        SHARF_THROW_IF(not file.good(), "Failed to read ", filename.native());
+
+        return (dictionary);
+    }
+
+
+    void ZstdDictionary::save(const std::filesystem::path &filename, const std::vector<std::byte> &dictionary)
+    {
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        SHARF_THROW_IF(not file.is_open(), "Failed to open ", filename.native());
+
+        file.write(
+                reinterpret_cast<const char *>(dictionary.data()),  // NOLINT
+                static_cast<std::streamsize>(dictionary.size()));
+        SHARF_THROW_IF(not file.good(), "Failed to write ", filename.native());
+    }
+}  // namespace pjmsg_mcap_wrapper
@@ -0,0 +1,251 @@
+/**
+    @file
+    @author Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief Checks that Writer::tryWrite() does not allocate memory or query
+    system clocks after Writer::reserve(): memory allocation and clock
+    functions are interposed and counted while tryWrite() is running.
+*/
+
+#include <pjmsg_mcap_wrapper/all.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+
+extern "C"
+{
+    // glibc
+    void *__libc_malloc(std::size_t size);                           // NOLINT
+    void *__libc_calloc(std::size_t count, std::size_t size);        // NOLINT
+    void *__libc_realloc(void *pointer, std::size_t size);           // NOLINT
+    void *__libc_memalign(std::size_t alignment, std::size_t size);  // NOLINT
+}
+
+
+namespace
+{
+    /// Calls are counted only in the real-time section of the test thread.
+    thread_local bool realtime = false;
+    thread_local std::size_t allocations = 0;
+    thread_local std::size_t clock_calls = 0;
+
+
+    class RealtimeSection
+    {
+    public:
+        RealtimeSection()
+        {
+            realtime = true;
+        }
+
+        ~RealtimeSection()
+        {
+            realtime = false;
+        }
+    };
+
+
+    void count(std::size_t &counter)
+    {
+        if (realtime)
+        {
+            ++counter;
+        }
+    }
+}  // namespace
+
+
+extern "C"
+{
+    void *malloc(std::size_t size)  // NOLINT
+    {
+        count(allocations);
+        return (__libc_malloc(size));
+    }
+
+    void *calloc(std::size_t count_, std::size_t size)  // NOLINT
+    {
+        count(allocations);
+        return (__libc_calloc(count_, size));
+    }
+
+    void *realloc(void *pointer, std::size_t size)  // NOLINT
+    {
+        count(allocations);
+        return (__libc_realloc(pointer, size));
+    }
+
+    void *aligned_alloc(std::size_t alignment, std::size_t size)  // NOLINT
+    {
+        count(allocations);
+        return (__libc_memalign(alignment, size));
+    }
+
+    int posix_memalign(void **pointer, std::size_t alignment, std::size_t size)  // NOLINT
+    {
+        count(allocations);
+        *pointer = __libc_memalign(alignment, size);
+        return ((nullptr == *pointer) ? ENOMEM : 0);
+    }
+
+    int clock_gettime(clockid_t clock_id, struct timespec *time)  // NOLINT
+    {
+        count(clock_calls);
+        return (static_cast<int>(syscall(SYS_clock_gettime, clock_id, time)));
+    }
+
+    int gettimeofday(struct timeval *time, void *timezone)  // NOLINT
+    {
+        count(clock_calls);
+        return (static_cast<int>(syscall(SYS_gettimeofday, time, timezone)));
+    }
+}
+
+
+namespace
+{
+    using Parameters = pjmsg_mcap_wrapper::Writer::Parameters;
+
+    constexpr std::size_t SIGNALS = 200;
+    constexpr std::size_t MESSAGES = 20000;
+    /// The queue is drained after every PAUSE messages and overflows in between.
+    constexpr std::size_t PAUSE = 64;
+
+    bool check(const bool condition, const std::string &what)
+    {
+        if (not condition)
+        {
+            std::cerr << "FAILED: " << what << std::endl;
+        }
+        return (condition);
+    }
+
+
+    /// Interposed functions must be called instead of glibc ones.
+    bool testHooks()
+    {
+        struct timespec time;
+        void *volatile memory;
+        {
+            const RealtimeSection section;
+            memory = std::malloc(16);  // NOLINT
+            clock_gettime(CLOCK_MONOTONIC, &time);
+        }
+        std::free(memory);  // NOLINT
+
+        const bool result = check(1 == allocations and 1 == clock_calls, "malloc and clock hooks");
+        allocations = 0;
+        clock_calls = 0;
+        return (result);
+    }
+
+
+    bool testTryWrite(const std::string &filename, const Parameters::Clock clock)
+    {
+        Parameters params;
+        params.async_ = true;
+        params.async_queue_size_ = 4;
+        params.backpressure_ = Parameters::Backpressure::DROP_NEWEST;
+        params.compression_ = Parameters::Compression::ZSTD;
+        params.clock_ = clock;
+
+        pjmsg_mcap_wrapper::Message message;
+        message.resize(SIGNALS);
+        for (std::size_t i = 0; i < SIGNALS; ++i)
+        {
+            message.name(i) = "signal_" + std::to_string(i);
+        }
+
+        std::size_t accepted = 0;
+        std::size_t attempts = 0;
+        pjmsg_mcap_wrapper::Writer::QueueStatistics statistics;
+        {
+            pjmsg_mcap_wrapper::Writer writer;
+            writer.initialize(filename, "/test", params);
+            writer.reserve(message);
+
+            for (std::size_t k = 0; k < MESSAGES; ++k)
+            {
+                message.setStamp(1000000000 + k * 1000000);
+                for (std::size_t i = 0; i < SIGNALS; ++i)
+                {
+                    message.value(i) = static_cast<double>(k + i);
+                }
+                // name updates are attempted right after pauses, when the queue is empty
+                if (PAUSE * 150 + 1 == k)
+                {
+                    // fits into reserved names
+                    message.name(3) = "renamed";
+                    message.bumpVersion();
+                }
+                if (PAUSE * 300 + 1 == k)
+                {
+                    // does not fit
+                    message.name(4) = std::string(100, 'x');
+                    message.bumpVersion();
+                }
+
+                {
+                    const RealtimeSection section;
+                    accepted += writer.tryWrite(message) ? 1 : 0;
+                }
+                ++attempts;
+
+                if (0 == k % PAUSE)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                }
+            }
+
+            statistics = writer.getQueueStatistics();
+        }
+
+        bool result = true;
+        result = check(0 == allocations, "no memory allocations, got " + std::to_string(allocations)) and result;
+        result = check(0 == clock_calls, "no clock calls, got " + std::to_string(clock_calls)) and result;
+        result = check(statistics.queued_ == accepted, "queued messages are counted") and result;
+        result = check(statistics.overflows_ > 0, "overflows are counted") and result;
+        result = check(statistics.rejected_ > 0, "rejected messages are counted") and result;
+        result = check(
+                         statistics.queued_ + statistics.overflows_ + statistics.rejected_ == attempts,
+                         "all messages are accounted for")
+                 and result;
+
+        std::cout << "attempts " << attempts << ", queued " << statistics.queued_ << ", overflows "
+                  << statistics.overflows_ << ", rejected " << statistics.rejected_ << std::endl;
+
+        allocations = 0;
+        clock_calls = 0;
+        return (result);
+    }
+}  // namespace
+
+
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <output.mcap>" << std::endl;  // NOLINT
+        return (EXIT_FAILURE);
+    }
+    const std::string filename = argv[1];  // NOLINT
+
+    bool result = testHooks();
+    result = testTryWrite(filename, Parameters::Clock::MESSAGE_STAMP) and result;
+#if defined(__x86_64__) || defined(__i386__)
+    result = testTryWrite(filename, Parameters::Clock::TSC) and result;
+#endif
+
+    return (result ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,96 @@
+/**
+    @file
+    @author Alexander Sherikov
+    @copyright 2025-2026 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief Checks that ValuesSerializer output is identical to FastCDR for
+    various frame_id lengths (padding) and values counts.
+*/
+
+#include "3rdparty.h"
+#include "util.h"
+#include "values_serializer.h"
+
+#include "HeaderCdrAux.ipp"
+#include "StatisticsValuesCdrAux.ipp"
+#include "StatisticsValuesFloat32CdrAux.ipp"
+#include "TimeCdrAux.ipp"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    template <class t_Message>
+    std::vector<std::byte> serializeFastCdr(const plotjuggler_msgs::msg::StatisticsValues &input)
+    {
+        t_Message message;
+        message.header() = input.header();
+        message.values().assign(input.values().begin(), input.values().end());
+        message.names_version(input.names_version());
+
+        std::vector<std::byte> buffer(
+                64 + input.header().frame_id().size() + input.values().size() * sizeof(double), std::byte{ 0 });
+
+        eprosima::fastcdr::FastBuffer cdr_buffer(reinterpret_cast<char *>(buffer.data()), buffer.size());  // NOLINT
+        eprosima::fastcdr::Cdr ser(
+                cdr_buffer, eprosima::fastcdr::Cdr::DEFAULT_ENDIAN, eprosima::fastcdr::CdrVersion::XCDRv1);
+        ser.set_encoding_flag(eprosima::fastcdr::EncodingAlgorithmFlag::PLAIN_CDR);
+
+        ser.serialize_encapsulation();
+        ser << message;
+        ser.set_dds_cdr_options({ 0, 0 });
+
+        buffer.resize(ser.get_serialized_data_length());
+        return (buffer);
+    }
+
+
+    /// The same serializer is reused, as in Writer, so that header updates
+    /// are checked too.
+    template <class t_Message>
+    bool test(const char *type)
+    {
+        pjmsg_mcap_wrapper::ValuesSerializer<t_Message> serializer;
+        bool result = true;
+
+        for (const std::size_t frame_id_size : { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 17 })
+        {
+            for (const std::size_t count : { 0, 1, 2, 3, 1000 })
+            {
+                plotjuggler_msgs::msg::StatisticsValues message;
+                message.header().frame_id() = std::string(frame_id_size, 'f');
+                message.header().stamp().sec(123456);
+                message.header().stamp().nanosec(789);
+                message.names_version(42);
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    message.values().push_back(static_cast<double>(i) * 0.1 - 3.0);
+                }
+
+                std::vector<std::byte> buffer(serializer.getSize(message));
+                serializer.serialize(buffer.data(), message);
+
+                if (serializeFastCdr<t_Message>(message) != buffer)
+                {
+                    std::cerr << "FAILED: " << type << ", frame_id size " << frame_id_size << ", count " << count
+                              << std::endl;
+                    result = false;
+                }
+            }
+        }
+        return (result);
+    }
+}  // namespace
+
+
+int main()
+{
+    bool result = test<plotjuggler_msgs::msg::StatisticsValues>("double");
+    result = test<plotjuggler_msgs::msg::StatisticsValuesFloat32>("float32") and result;
+
+    return (result ? EXIT_SUCCESS : EXIT_FAILURE);
+}